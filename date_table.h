@@ -0,0 +1,155 @@
+#ifndef DATE_TABLE_H
+#define DATE_TABLE_H
+
+/*
+date_table : table driven date math for 2 digit years (2000 - 2099)
+
+A date is a day number (days since 01/01/2000), a time is seconds since
+00:00:00 01/01/2000. Both directions are a PROGMEM cumulative days lookup and
+a few adds, no month by month or year by year loops.
+
+date_add() is a drop in for addTimezone<>() from TimeDateTools :
+	date_add<uint8_t>(hh, mm, ss, DD, MM, YY, tz_hh, tz_mm, seconds);
+Only a change of day touches the date, i.e. the 1 second increment is a couple of compares
+*/
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+
+#define DATE_SECONDS_PER_DAY 86400L
+#define DATE_MINUTES_PER_DAY 1440
+#define DATE_DAYS_PER_CYCLE 1461 // 4 years, 2000 - 2099 has a leap year every 4 years
+#define DATE_DAYS_PER_CENTURY 36525U // 2 digit years wrap from 99 to 00
+
+// Cumulative days before the start of each month, [0] = non leap year, [1] = leap year
+// The 13th entry is the length of the year
+const uint16_t date_days_before_month[2][13] PROGMEM = {
+	{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+	{ 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 } };
+
+inline bool date_is_leap_year(const uint8_t YY)
+{
+	// 2 digit year, valid from 1901 to 2099
+	return (YY & 0x03) == 0;
+}
+
+// 1 = 1st of January
+inline uint16_t date_day_of_year(const uint8_t DD, const uint8_t MM, const uint8_t YY)
+{
+	return pgm_read_word(&date_days_before_month[date_is_leap_year(YY)][MM - 1]) + DD;
+}
+
+inline uint8_t date_days_in_month(const uint8_t MM, const uint8_t YY)
+{
+	const uint16_t *days = date_days_before_month[date_is_leap_year(YY)];
+	return pgm_read_word(&days[MM]) - pgm_read_word(&days[MM - 1]);
+}
+
+// Days since 01/01/2000
+inline uint16_t date_to_days(const uint8_t DD, const uint8_t MM, const uint8_t YY)
+{
+	// 365 days per year plus a day for every leap year before this one (2000 is one)
+	return YY * 365U + ((YY + 3) >> 2) + date_day_of_year(DD, MM, YY) - 1;
+}
+
+inline void date_from_days(const uint16_t days, uint8_t &DD, uint8_t &MM, uint8_t &YY)
+{
+	// year : the first year of each 4 year cycle is the leap year
+	const uint8_t cycle = days / DATE_DAYS_PER_CYCLE;
+	uint16_t doy = days - cycle * DATE_DAYS_PER_CYCLE;
+	uint8_t year = 0;
+	if (doy >= 366)
+	{
+		year = (doy - 1) / 365;
+		doy -= year * 365 + 1;
+	}
+	YY = (cycle << 2) + year;
+
+	// month : every month is 28 to 31 days, so doy/32 is the month or the one before it
+	const uint16_t *before = date_days_before_month[year == 0];
+	uint8_t month = doy >> 5;
+	if (doy >= pgm_read_word(&before[month + 1]))
+	{
+		++month;
+	}
+	MM = month + 1;
+	DD = doy - pgm_read_word(&before[month]) + 1;
+}
+
+// Seconds since 00:00:00 01/01/2000
+inline uint32_t date_to_seconds(const uint8_t hh, const uint8_t mm, const uint8_t ss,
+	const uint8_t DD, const uint8_t MM, const uint8_t YY)
+{
+	return date_to_days(DD, MM, YY) * static_cast<uint32_t>(DATE_SECONDS_PER_DAY)
+		+ (hh * 60U + mm) * 60UL + ss;
+}
+
+inline void date_from_seconds(const uint32_t t, uint8_t &hh, uint8_t &mm, uint8_t &ss,
+	uint8_t &DD, uint8_t &MM, uint8_t &YY)
+{
+	const uint16_t days = t / DATE_SECONDS_PER_DAY;
+	uint32_t sod = t - days * static_cast<uint32_t>(DATE_SECONDS_PER_DAY);
+	const uint16_t mod = sod / 60;
+	ss = sod - mod * 60UL;
+	hh = mod / 60;
+	mm = mod - hh * 60;
+	date_from_days(days, DD, MM, YY);
+}
+
+// Add a timezone (hours, minutes) and a number of seconds to the time and date
+// Note : the signs of tz_hh and tz_mm are independent, i.e. -9:30 is (-9, -30)
+template <typename T>
+void date_add(T &hh, T &mm, T &ss, T &DD, T &MM, T &YY, const int8_t tz_hh, const int8_t tz_mm, const int32_t seconds)
+{
+	// seconds, carried into minutes
+	int32_t minutes = 0;
+	int32_t s = static_cast<int32_t>(ss) + seconds;
+	if ((s < 0) | (s >= 60))
+	{
+		minutes = s / 60;
+		s -= minutes * 60;
+		if (s < 0)
+		{
+			s += 60;
+			--minutes;
+		}
+	}
+	ss = s;
+
+	// minute of the day, carried into days
+	minutes += hh * 60 + mm + tz_hh * 60 + tz_mm;
+	int32_t days = 0;
+	if ((minutes < 0) | (minutes >= DATE_MINUTES_PER_DAY))
+	{
+		days = minutes / DATE_MINUTES_PER_DAY;
+		minutes -= days * DATE_MINUTES_PER_DAY;
+		if (minutes < 0)
+		{
+			minutes += DATE_MINUTES_PER_DAY;
+			--days;
+		}
+	}
+	const uint16_t mod = minutes;
+	hh = mod / 60;
+	mm = mod - hh * 60;
+
+	if (days != 0)
+	{
+		days += date_to_days(DD, MM, YY);
+		if (days < 0)
+		{
+			days += DATE_DAYS_PER_CENTURY;
+		}
+		else if (days >= static_cast<int32_t>(DATE_DAYS_PER_CENTURY))
+		{
+			days -= DATE_DAYS_PER_CENTURY;
+		}
+		uint8_t dd, mo, yy;
+		date_from_days(days, dd, mo, yy);
+		DD = dd;
+		MM = mo;
+		YY = yy;
+	}
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef EPOCH_CLOCK_H
+#define EPOCH_CLOCK_H
+
+/*
+epoch_clock : seconds since 00:00:00 01/01/2000, see date_table.h
+
+One 32 bit count holds the time, the hh:mm:ss DD/MM/YY breakdown is only done
+when asked for (get()), and the date part is cached until the day changes.
+
+The seconds are either ticked by an interrupt (tick(), e.g. the wwvb_frame
+Timer1 ISR at the start of every transmitted second) or, while nothing ticks
+it, freewheel on millis() (update()). tick() keeps the millis() phase of the
+second, so switching between the two neither jumps nor drifts.
+*/
+
+#include <Arduino.h>
+#include "wwvb_port.h"
+#include "date_table.h"
+
+class epoch_clock
+{
+private:
+	volatile uint32_t _seconds;
+	volatile uint32_t _t0; // millis() at the start of the current second
+	volatile bool _ticked;
+
+	// date cache for get()
+	uint16_t _day;
+	uint8_t _DD, _MM, _YY;
+public:
+	epoch_clock() : _seconds(0), _t0(0), _ticked(false), _day(0xFFFF), _DD(1), _MM(1), _YY(0) {}
+
+	// Set the time, the current second starts now
+	void set(const uint32_t t)
+	{
+		const uint32_t t0 = millis();
+		cli();
+		_seconds = t;
+		_t0 = t0;
+		sei();
+	}
+
+	void set(const uint8_t hh, const uint8_t mm, const uint8_t ss, const uint8_t DD, const uint8_t MM, const uint8_t YY)
+	{
+		set(date_to_seconds(hh, mm, ss, DD, MM, YY));
+	}
+
+	uint32_t now()
+	{
+		cli();
+		const uint32_t t = _seconds;
+		sei();
+		return t;
+	}
+
+	// The time and the milliseconds into its second, read together
+	uint32_t now(uint16_t &ms)
+	{
+		cli();
+		const uint32_t t = _seconds;
+		const uint32_t t0 = _t0;
+		sei();
+		const uint32_t dt = millis() - t0;
+		ms = (dt < 1000) ? dt : 999;
+		return t;
+	}
+
+	// Milliseconds into the current second
+	uint16_t ms()
+	{
+		cli();
+		const uint32_t t0 = _t0;
+		sei();
+		const uint32_t dt = millis() - t0;
+		return (dt < 1000) ? dt : 999;
+	}
+
+	// true : the seconds are counted by tick(), false : update() freewheels on millis()
+	void ticked(const bool on) { _ticked = on; }
+
+	// Call from an ISR at the start of every second
+	inline void tick()
+	{
+		++_seconds;
+		_t0 = millis();
+	}
+
+	// Call from loop(), counts the seconds while nothing calls tick()
+	// Returns true if the second changed
+	bool update()
+	{
+		if (_ticked)
+		{
+			return false;
+		}
+		bool changed = false;
+		const uint32_t t = millis();
+		while (t - _t0 >= 1000)
+		{
+			_t0 += 1000;
+			++_seconds;
+			changed = true;
+		}
+		return changed;
+	}
+
+	// The time + offset seconds, e.g. a timezone difference
+	void get(uint8_t &hh, uint8_t &mm, uint8_t &ss, uint8_t &DD, uint8_t &MM, uint8_t &YY, const int32_t offset = 0)
+	{
+		const uint32_t t = now() + offset;
+		const uint16_t day = t / DATE_SECONDS_PER_DAY;
+		const uint32_t sod = t - day * static_cast<uint32_t>(DATE_SECONDS_PER_DAY);
+		const uint16_t mod = sod / 60;
+		ss = sod - mod * 60UL;
+		hh = mod / 60;
+		mm = mod - hh * 60;
+		if (day != _day)
+		{
+			date_from_days(day, _DD, _MM, _YY);
+			_day = day;
+		}
+		DD = _DD;
+		MM = _MM;
+		YY = _YY;
+	}
+};
+
+#endif
@@ -1,9 +1,10 @@
 #include <Arduino.h>
-//ATtiny85 (doesn't fit yet - a rework of ATtinyGPS is planned)
+//ATtiny85 (GPS_SERIAL 3 and GPS_PARSER 1, the defaults on the ATtiny)
+//Note : the fit in 8K flash / 512 bytes SRAM is unmeasured, check it with extras/footprint/footprint.py --board attiny85
 //                     +-\/-+
 //            RST PB5 1|*   |8 VCC
-//                PB3 2|    |7 PB2 <= GPS Tx (Software Serial)
-//WWVB ANTENNA <= PB4 3|    |6 PB1 => GPS Rx (Software Serial)
+//                PB3 2|    |7 PB2 <= GPS Tx (tiny_uart, INT0)
+//WWVB ANTENNA <= PB4 3|    |6 PB1 => GPS Rx (tiny_uart)
 //                GND 4|    |5 PB0
 //                     +----+
 //
@@ -93,9 +94,11 @@ ATtiny85   | *USE_OC1B | D4 / PB4 (pin 3)
 -----------+-----------+-----------------
 ATmega32u4 | *USE_OC1A | D9
 ATmega32u4 |  USE_OC1B | D10
+ATmega32u4 |  both     | D9 + D10 (two coils or an H-bridge, see set_output_b())
 -----------+-----------+-----------------
 ATmega328p | *USE_OC1A | D9
 ATmega328p |  USE_OC1B | D10
+ATmega328p |  both     | D9 + D10 (two coils or an H-bridge, see set_output_b())
 -----------+-----------+-----------------
 
 * Default setup
@@ -129,22 +132,176 @@ unsigned char LED_PIN = PB13;
 unsigned char LED_PIN = 13;
 #endif
 
-uint16_t LED_FAST = 100;
-uint16_t SLOW_DELAY = 1000;
 bool LED_TOGGLE = false;
-uint32_t t0;
 uint8_t last_satellites = 0;
 
-#include <TimeDateTools.h> // include before wwvb.h AND/OR ATtinyGPS.h
-#include <wwvb.h> // include before ATtinyGPS.h
-wwvb wwvb_tx;
+#include <TimeDateTools.h> // include before ATtinyGPS.h
+// ISR timing instrumentation (ATmega only)
+// Records the Timer1 overflow interrupt latency / duration in CPU cycles, printed with _DEBUG > 0
+// 0 = off
+// 1 = on
+#define WWVB_ISR_STATS 0
+// Loopback self check, the ISR traces what it emitted and wwvb_tx.update() decodes it like a clock
+// Counts the seconds that late interrupts (display, GPS) pushed out of the pulse width tolerance
+// 0 = off
+// 1 = on (240 bytes of RAM)
+#define WWVB_LOOPBACK 0
+// Resync drift telemetry, the transmitted second is timed against the GPS second at every resync
+// and without a GPS PPS the rate error is taken out of the calibration (see wwvb_frame.h)
+// 0 = off
+// 1 = on
+#define WWVB_DRIFT 1
+// Reduced power level, pulse width in percent of the high level
+// 0 = carrier off (most clocks decode this fine)
+// WWVB_PWM_LOW_TRUE = the level of the real transmitter, WWVB -17dB (DCF77 15%, JJY 10%, MSF off)
+#define WWVB_PWM_LOW 0
+#include <wwvb_frame.h> // include before ATtinyGPS.h, includes date_table.h (date_add())
+
+// Time code standard, the signal your clock is built for (see timecode.h)
+// TIMECODE_WWVB  : WWVB 60kHz (USA)
+// TIMECODE_DCF77 : DCF77 77.5kHz (Germany)
+// TIMECODE_JJY40 : JJY 40kHz (Japan, east)
+// TIMECODE_JJY60 : JJY 60kHz (Japan, west)
+// TIMECODE_MSF   : MSF 60kHz (UK)
+// TIMECODE_BPC   : BPC 68.5kHz (China)
+// TIMECODE_ROUND_ROBIN : the standards in tx_rotation_slots take turns, tx_rotation minutes each
+// Note : set wwvb_timezone to the time the clock expects e.g. DCF77 = UTC+1, JJY = UTC+9, BPC = UTC+8
+#define TIMECODE TIMECODE_WWVB
+
+// Carrier timer (see wwvb_timer1 / wwvb_timer2 in wwvb_frame.h)
+// WWVB_TIMER 1 : Timer1 fast PWM on OC1A (D9), any reduced power level
+// WWVB_TIMER 2 : Timer2 toggling OC2A (D11, ATmega328p), carrier off for the reduced power, Timer1 is left free
+// Note : both dither TOP onto the carrier (WWVB_DITHER), without it Timer2 at 16MHz makes 60.150kHz and Timer1
+// 59.925kHz, outside the receiver pass band (see the carrier table in wwvb_frame.h, TIMECODE_CARRIER_STRICT)
+#define WWVB_TIMER 1
+#if (WWVB_TIMER == 2) & (defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__) | defined(__AVR_ATtiny25__) | defined(__AVR_ATtiny45__) | defined(__AVR_ATtiny85__))
+#error The 32u4 and the ATtiny85 have no Timer2, set WWVB_TIMER 1
+#endif
+#if (WWVB_TIMER == 2)
+timecode_tx<TIMECODE, wwvb_timer2> wwvb_tx;
+#else
+timecode_tx<TIMECODE> wwvb_tx;
+#endif
+
+#if (TIMECODE == TIMECODE_ROUND_ROBIN)
+// Standard, timezone added to the GPS time for it (as wwvb_tx.setTimezone(), wwvb_timezone is not used)
+// The Timer1 TOP is switched to each carrier on the minute boundary
+// Note : most clocks want a few good frames in a row, use windows of several minutes and CONTINUOUS_TX 1
+const timecode_slot tx_rotation_slots[] PROGMEM = {
+	{TIMECODE_WWVB, 6, 0},   // CST (UTC -6:00) + 6 = UTC
+	{TIMECODE_DCF77, 7, 0},  // CET (UTC +1:00)
+	{TIMECODE_JJY60, 15, 0}  // JST (UTC +9:00)
+	};
+timecode_rotation tx_rotation(tx_rotation_slots, sizeof(tx_rotation_slots) / sizeof(tx_rotation_slots[0]), 10);
+#endif
+
+// Daylight saving time rule for the DST bits, evaluated every minute on the local GPS time (see timecode_dst.h)
+// TIMECODE_DST_NONE : standard time only
+// TIMECODE_DST_US, TIMECODE_DST_EU or TIMECODE_DST_AU : summer time is sent and the clock adds the hour itself
+// Note : with a rule set local_timezone to the standard time (e.g. ACST = UTC +9:30)
+#define DST_RULE TIMECODE_DST_NONE
+
+// Resonator calibration in EEPROM (see wwvb_calibration.h)
+// 0 = off
+// 1 = the trim learned from the GPS PPS (or the resync drift) is saved once it settles, and loaded at boot
+#define WWVB_CALIBRATION 0
+#if (WWVB_CALIBRATION == 1)
+#include <wwvb_calibration.h>
+wwvb_calibration calibration;
+#endif
 
 // The ISR sets the PWM pulse width to correspond with the WWVB bit
+// Note : the frame is precomputed by wwvb_tx.update() in loop(), the ISR only indexes it
+#if (WWVB_TIMER == 2)
+ISR(TIMER2_COMPA_vect)
+#else
 ISR(TIMER1_OVF_vect)
+#endif
 {
 	wwvb_tx.interrupt_routine();
 }
 
+// GPS PPS (pulse per second) input, disciplines the wwvb second boundaries to the GPS edge
+// 0 : no PPS (use calibrate()), 2 or 3 : PPS on INT0/INT1 (INT1/INT0 on the 32u4)
+#define GPS_PPS_PIN 0
+
+#if (WWVB_CALIBRATION == 1) & (GPS_PPS_PIN == 0) & (WWVB_DRIFT == 0)
+#error WWVB_CALIBRATION learns the trim from the GPS PPS or the resync drift, set GPS_PPS_PIN or WWVB_DRIFT 1
+#endif
+
+#if (GPS_PPS_PIN > 0)
+void pps_interrupt()
+{
+	wwvb_tx.pps_interrupt();
+}
+#endif
+
+// GPS serial
+// GPS_SERIAL 0 : SoftwareSerial, its pin change interrupts are disabled while wwvb transmits
+// GPS_SERIAL 1 : HardwareSerial
+// GPS_SERIAL 2 : gps_uart.h, USART RX interrupt into a small ring buffer
+// GPS_SERIAL 3 : tiny_uart.h (ATtiny only), INT0 start bit edge and Timer0 compare B bit timing, no USART needed
+// Note : GPS_SERIAL 1 or 2 uses Serial1 on the 32u4 and Serial on the 328p (GPS Tx => RX1, set _DEBUG 0)
+#if defined(__AVR_ATtiny25__) | defined(__AVR_ATtiny45__) | defined(__AVR_ATtiny85__)
+#define GPS_SERIAL 3
+#else
+#define GPS_SERIAL 0
+#endif
+
+// GPS parser
+// GPS_PARSER 0 : ATtinyGPS
+// GPS_PARSER 1 : nmea_time.h, only the RMC time/date and GGA fix fields, no sentence buffer (for the ATtiny85)
+#if defined(__AVR_ATtiny25__) | defined(__AVR_ATtiny45__) | defined(__AVR_ATtiny85__)
+#define GPS_PARSER 1
+#else
+#define GPS_PARSER 0
+#endif
+
+// CONTINUOUS_TX 0 : wwvb transmits for 9 minutes then stops for a minute to resync with GPS
+// CONTINUOUS_TX 1 : wwvb transmits continuously while the GPS time is read in the background
+//                   and checked against the wwvb time every minute (needs GPS_SERIAL 1, 2 or 3)
+#define CONTINUOUS_TX 0
+
+#if (CONTINUOUS_TX == 1) & (GPS_SERIAL == 0)
+#error CONTINUOUS_TX needs the GPS on an interrupt driven reader, set GPS_SERIAL 1, 2 or 3
+#endif
+
+// Holdover time source, a battery backed DS3231 RTC on the I2C pins (see rtc_ds3231.h)
+// HOLDOVER_RTC 0 : nothing is transmitted until the GPS has a fix
+// HOLDOVER_RTC 1 : from boot the RTC time is transmitted (holdover) until the GPS has a fix, then the GPS
+//                  time takes over at a minute boundary and is written back to the RTC (needs CONTINUOUS_TX 1)
+#define HOLDOVER_RTC 0
+
+#if (HOLDOVER_RTC == 1)
+#if (CONTINUOUS_TX == 0)
+#error HOLDOVER_RTC hands over to the GPS while transmitting, set CONTINUOUS_TX 1
+#endif
+#if (defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)) & (GPS_PPS_PIN > 0)
+#error The 32u4 I2C pins are D2/D3, move the GPS PPS or set HOLDOVER_RTC 0
+#endif
+#include <rtc_ds3231.h>
+rtc_ds3231 rtc;
+bool holdover = false; // transmitting the RTC time
+uint8_t rtc_ss = 0xFF; // the RTC second at the last poll
+#endif
+
+// Binary status frames for remote monitoring (see wwvb_status.h), every 10s on Serial
+// 0 = off
+// 1 = on, set _DEBUG 0 for a stream of frames only (a reader finds them between the debug lines too)
+#define WWVB_STATUS 0
+
+#if (WWVB_STATUS == 1)
+#if defined(__AVR_ATtiny25__) | defined(__AVR_ATtiny45__) | defined(__AVR_ATtiny85__)
+#error The ATtiny85 has no serial port for the status frames, set WWVB_STATUS 0
+#endif
+#if !(defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)) & (GPS_SERIAL != 0)
+#error The GPS uses Serial, set GPS_SERIAL 0 or WWVB_STATUS 0
+#endif
+#include <wwvb_status.h>
+wwvb_status<decltype(wwvb_tx)> status(wwvb_tx);
+#endif
+
+#if (GPS_SERIAL == 0)
 #include <SoftwareSerial.h>
 #if defined(__AVR_ATtiny25__) | defined(__AVR_ATtiny45__) | defined(__AVR_ATtiny85__)
 SoftwareSerial ttl(2, 1);// Rx, Tx pin
@@ -153,12 +310,142 @@ SoftwareSerial ttl(10, 6);// Rx, Tx pin
 #else
 SoftwareSerial ttl(7, 6);// Rx, Tx pin
 #endif
+#elif (GPS_SERIAL == 3)
+#include <tiny_uart.h>
+tiny_uart ttl;
+
+// One short interrupt per bit, the carrier ISR is never held off for a whole byte
+ISR(INT0_vect)
+{
+	ttl.edge_interrupt();
+}
 
-//#define GPS_MODULE 0 // ublox : Flash 16,812 bytes, SRAM 1299 bytes
-//#define GPS_MODULE 1 // mediatek (default) : Flash 16,138 bytes, SRAM 1053 bytes
+ISR(TIMER0_COMPB_vect)
+{
+	ttl.bit_interrupt();
+}
+#else
+#if defined(__AVR_ATtiny25__) | defined(__AVR_ATtiny45__) | defined(__AVR_ATtiny85__)
+#error The ATtiny85 has no hardware UART, set GPS_SERIAL 0 or 3
+#endif
+#if !(defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)) & (_DEBUG > 0)
+#error The GPS uses Serial, set _DEBUG 0
+#endif
+#if (GPS_SERIAL == 2)
+#include <gps_uart.h>
+gps_uart ttl;
+
+// The ISR only moves the received byte into the ring buffer
+ISR(GPS_UART_RX_vect)
+{
+	ttl.interrupt_routine();
+}
+#elif defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)
+HardwareSerial &ttl = Serial1;
+#else
+HardwareSerial &ttl = Serial;
+#endif
+#endif
+
+#if (GPS_PARSER == 1)
+#include <nmea_time.h>
+nmea_time gps;
+#else
+//#define GPS_MODULE 0 // ublox
+//#define GPS_MODULE 1 // mediatek (default)
+// Note : the flash / SRAM / stack of each option and board is in the extras/footprint report
 
 #include <ATtinyGPS.h>
 ATtinyGPS gps;
+#endif
+
+// Only the RMC and GGA sentences reach gps.parse(), the rest are dropped after the header
+//#define NMEA_SENTENCES (NMEA_RMC | NMEA_GGA)
+#include <nmea_filter.h>
+nmea_filter nmea;
+
+// 1 : tell the GPS module to stop sending the sentences that are filtered out
+#define NMEA_CONFIGURE 0
+
+// GPS bytes parsed per slice of loop() (9600 baud is ~1 byte/ms), the rest wait in the UART buffer
+#define GPS_PARSE_BUDGET 32
+
+#include <wwvb_tasks.h>
+extern wwvb_tasks tasks; // the task table is below the tasks, before loop()
+
+// SLEEP_IDLE 1 : idle the CPU between interrupts, Timer1 keeps generating the carrier
+#define SLEEP_IDLE 1
+
+// GPS_POWER_PIN > 0 : switches the GPS module supply (e.g. a P-channel MOSFET gate, LOW = on)
+// The GPS is off while wwvb transmits and powered up a minute before each resync
+// Note : CONTINUOUS_TX 1 keeps the GPS on
+// Note : the MCU Tx => GPS Rx line can back power the module, use a series resistor
+#define GPS_POWER_PIN 0
+#define GPS_POWER_ON LOW
+
+// ESTIMATED supply current per mode, ATmega328p @ 16MHz/5V, worked out from datasheet / typical module
+// figures and NOT measured on a board. Check a build with a meter in series with the supply (the GPS
+// averaged over a full 10 minute cycle) before relying on these numbers.
+// -----------------------------+--------+----------------------+---------
+// Mode (estimate)              | MCU    | GPS (ublox 6M / MTK) | Total
+// -----------------------------+--------+----------------------+---------
+// busy loop, GPS always on     | ~10mA  | ~40mA / ~25mA        | 35-50mA
+// SLEEP_IDLE                   |  ~6mA  | ~40mA / ~25mA        | 31-46mA
+// SLEEP_IDLE + GPS_POWER_PIN   |  ~6mA  | on 2 of every 10 min | 11-14mA
+// -----------------------------+--------+----------------------+---------
+// Not included : power LED (~3mA), USB serial chip, LCD backlight, the coil
+// Note : the Timer1 overflow wakes the CPU every carrier cycle, so IDLE saves ~40% rather than ~70%
+
+#include <avr/sleep.h>
+#include <avr/power.h>
+
+void idle()
+{
+#if (SLEEP_IDLE == 1)
+	// wakes on the next interrupt (Timer1 overflow, millis(), GPS serial, PPS)
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sleep_cpu();
+	sleep_disable();
+#endif
+}
+
+void gpsPower(const bool on)
+{
+#if (GPS_POWER_PIN > 0)
+	digitalWrite(GPS_POWER_PIN, on ? GPS_POWER_ON : !GPS_POWER_ON);
+#endif
+}
+
+// TX_SCHEDULE 1 : only transmit inside the tx_windows (local time), standby with the GPS off outside them
+#define TX_SCHEDULE 0
+
+#if (TX_SCHEDULE == 1)
+#include <wwvb_schedule.h>
+
+// { start hh, start mm, end hh, end mm } e.g. when the clocks try to receive
+const wwvb_window tx_windows[] PROGMEM = { { 1, 0, 3, 30 } };
+wwvb_schedule schedule(tx_windows, sizeof(tx_windows) / sizeof(wwvb_window), 10); // GPS on 10 minutes early
+#endif
+
+// Returns false if the local time hh:mm:ss is outside the transmit windows, and stands by
+// unless the next window is within the warmup (the GPS stays on and syncing until it opens)
+bool transmitWindow(const uint8_t hh, const uint8_t mm, const uint8_t ss)
+{
+#if (TX_SCHEDULE == 1)
+	if (!schedule.in_window(hh, mm))
+	{
+		wwvb_tx.stop();
+		if (!schedule.warming(hh, mm))
+		{
+			schedule.standby(hh, mm, ss);
+			gpsPower(false);
+		}
+		return false;
+	}
+#endif
+	return true;
+}
 
 const int8_t local_timezone[2] = {10, 30};
 const int8_t wwvb_timezone[2] = {-6, 0};
@@ -167,10 +454,38 @@ void setup()
 {
 	wwvb_tx.setup();
 
+	// nothing uses the ADC, analog comparator or TWI (except HOLDOVER_RTC)
+	ADCSRA = 0;
+	power_adc_disable();
+	ACSR |= _BV(ACD);
+#if (HOLDOVER_RTC == 1)
+	rtc.begin();
+#elif defined(power_twi_disable)
+	power_twi_disable();
+#endif
+#if (GPS_POWER_PIN > 0)
+	pinMode(GPS_POWER_PIN, OUTPUT);
+	gpsPower(true);
+#endif
+
 	// Set the wwvb calibration values
-	// ATmega328p : _DEBUG = 0 or 1 : frametime for calibrate( 86, 86) = 60.000254s
-	// ATmega32u4 : _DEBUG = 0 or 1 : frametime for calibrate(-6,-6) = 59.999825s
-	wwvb_tx.setPWM_LOW(0);
+	// The Timer1 TOP and carrier cycles per second are worked out from F_CPU at compile time,
+	// calibrate() trims that count for the resonator error (1 cycle ~ 17ppm @ 16MHz),
+	// calibrate_q16() in 1/65536 cycles for sub ppm steps
+	wwvb_tx.calibrate(0);
+#if (WWVB_CALIBRATION == 1)
+	// start from the trim learned on the last run
+	int32_t trim_q16;
+	if (calibration.load(trim_q16))
+	{
+		wwvb_tx.calibrate_q16(trim_q16);
+	}
+#endif
+#if (GPS_PPS_PIN > 0)
+	// the PPS edges trim the calibration continuously
+	pinMode(GPS_PPS_PIN, INPUT);
+	attachInterrupt(digitalPinToInterrupt(GPS_PPS_PIN), pps_interrupt, RISING);
+#endif
 
 	// set the timezone before you set your time
 	gps.setTimezone(local_timezone[0], local_timezone[1]); // set this to your local time e.g. (ACDT = UTC +10:30)
@@ -178,26 +493,51 @@ void setup()
 	// if you are using CST (UTC -6:00), set the timezone to +6,0
 	wwvb_tx.setTimezone(-wwvb_timezone[0], -wwvb_timezone[1]);
 
-#if (_DEBUG > 0)
+	// summer time, DUT1 (UT1 - UTC in 0.1s, IERS Bulletin D) and the next leap second (IERS Bulletin C)
+	wwvb_tx.set_dst_rule(DST_RULE);
+	wwvb_tx.set_dut1(0);
+	wwvb_tx.set_leap_second(0, 0); // none announced
+#if (TIMECODE == TIMECODE_ROUND_ROBIN)
+	wwvb_tx.set_rotation(tx_rotation);
+#endif
+#if (WWVB_DRIFT == 1)
+	// the PPS disciplines the trim every second, otherwise the resync drift does
+	wwvb_tx.set_drift_auto(GPS_PPS_PIN == 0);
+#endif
+
+#if (_DEBUG > 0) | (WWVB_STATUS == 1)
 	Serial.begin(9600);
 #if defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)
 	while (!Serial); // If using a leonardo/micro, wait for the Serial connection
 #endif
-	t0 = millis();
 #endif
 
 	pinMode(LED_PIN, OUTPUT);
 
+#if (GPS_SERIAL == 3)
+	ttl.begin(); // TINY_UART_BAUD, 9600
+#else
 	ttl.begin(9600);
+#endif
 
 	gps.setup(ttl);
+#if (NMEA_CONFIGURE == 1)
+	nmea_configure(ttl);
+#endif
 
 #if (_DEBUG > 0)
+	if (!wwvb_tx.CARRIER_RX)
+	{
+		Serial.print(F("Carrier is ")); Serial.print(wwvb_tx.CARRIER_ERROR_HZ);
+		Serial.println(F("Hz off, outside the receiver pass band"));
+	}
 	Serial.println(F("Waiting on first GPS sync (sync only occurs at 0s)"));
-	t0 = millis();
 #endif
+
+	startSync();
 }
 
+#if (GPS_SERIAL == 0)
 void disableSoftwareSerialRead()
 {
 	// Note : SoftwareSerial enables all pin change interrupt registers
@@ -254,71 +594,161 @@ void enableSoftwareSerialRead()
 	//          [  XTAL2|  XTAL1|    D13|    D11|    D12|    D10|     D9|     D8]
 #endif
 }
+#endif
 
 uint8_t mins = 0;
 
-void loop()
+// Encode the next minute's frame, once a minute the learned trim is checked for saving
+void updateFrame()
 {
-	// if we are receiving gps data, parse it
-	if (sync_gpstime)
+#if (WWVB_CALIBRATION == 1)
+	if (wwvb_tx.update())
+	{
+#if (WWVB_DRIFT == 1)
+		// disciplined by the PPS, or the resync drift has settled
+		calibration.update(wwvb_tx.trim_q16(), (wwvb_tx.pps_good_seconds() >= 50) | wwvb_tx.drift_settled());
+#else
+		calibration.update(wwvb_tx.trim_q16(), wwvb_tx.pps_good_seconds() >= 50);
+#endif
+	}
+#else
+	wwvb_tx.update();
+#endif
+}
+
+#if (HOLDOVER_RTC == 1)
+// Until the GPS has a fix, start transmitting the RTC time on its next minute boundary
+// The RTC is polled every 10ms, so the transmitted second is within ~10ms of the RTC second
+void holdoverStart()
+{
+	static uint32_t t_poll = 0;
+#if (TX_SCHEDULE == 1)
+	if (schedule.is_standby())
+	{
+		return;
+	}
+#endif
+	if (millis() - t_poll < 10)
+	{
+		return;
+	}
+	t_poll = millis();
+
+	uint8_t hh, mm, ss, DD, MM, YY;
+	if (!rtc.read_ss(ss))
+	{
+		return;
+	}
+	const bool minute = (ss == 0) & (rtc_ss != 0) & (rtc_ss != 0xFF);
+	rtc_ss = ss;
+	if (!minute)
 	{
-		enableSoftwareSerialRead(); // enable SoftwareSerial pin change interrupts
-		ttl.listen(); // reset buffer status
-		gps.new_data(); // clear gps.new_data
+		return;
+	}
 
-		// wait until we get gps data
-		char c;
-		while (!(((gps.IsValid) | (gps.YY < 80)) & ((gps.ss == 0) & gps.new_data())))
+	// no times from an RTC that has lost power
+	if (rtc.read(hh, mm, ss, DD, MM, YY))
+	{
+		wwvb_tx.clock.set(hh, mm, 0, DD, MM, YY);
+		if (transmitWindow(hh, mm, 0))
 		{
-			while (ttl.available())
-			{
-				c = ttl.read();
-				gps.parse(c);
+			wwvb_tx.set_time(hh, mm, DD, MM, YY);
+			wwvb_tx.start();
+			holdover = true;
+#if (_DEBUG > 0)
+			Serial.println(F("Start wwvb, RTC holdover"));
+#endif
+		}
+	}
+}
+#endif
+
+// Start reading the GPS, taskGPS sets the time on its next 0s sentence
+void startSync()
+{
+#if (GPS_SERIAL == 0)
+	enableSoftwareSerialRead(); // enable SoftwareSerial pin change interrupts
+	ttl.listen(); // reset buffer status
+#endif
+	gps.new_data(); // clear gps.new_data
+	sync_gpstime = true;
+}
+
+// GPS task : parse up to GPS_PARSE_BUDGET bytes, the UART buffers the rest until the next slice
+void taskGPS()
+{
+#if (CONTINUOUS_TX == 0)
+	if (!sync_gpstime)
+	{
+		return; // the GPS isn't read while wwvb transmits
+	}
+#endif
+	for (uint8_t n = 0; (n < GPS_PARSE_BUDGET) && ttl.available(); ++n)
+	{
+		const char c = ttl.read();
+		nmea.parse(gps, c);
 #if (_DEBUG == 2)
-				Serial.print(c);
+		Serial.print(c);
+#endif
+	}
+
+	// the gps sentence for 0s of the minute
+	if (gps.new_data() & (gps.ss == 0) & ((gps.IsValid) | (gps.YY < 80)))
+	{
+#if (WWVB_DRIFT == 1)
+		// how far the transmitted second has drifted from the GPS second, before the time is set from it
+		wwvb_tx.drift(date_to_seconds(gps.hh, gps.mm, gps.ss, gps.DD, gps.MM, gps.YY), nmea.burst_us());
+#endif
+#if (WWVB_STATUS == 1)
+		status.synced();
 #endif
-			}
+#if (CONTINUOUS_TX == 1)
+		// Only corrects the wwvb time (at the next minute boundary) if it has drifted
+		if (!transmitWindow(gps.hh, gps.mm, gps.ss))
+		{
+			wwvb_tx.clock.set(gps.hh, gps.mm, gps.ss, gps.DD, gps.MM, gps.YY); // standby, nothing ticks the clock
+		}
+		else if (wwvb_tx.sync_time(gps.hh, gps.mm, gps.DD, gps.MM, gps.YY))
+		{
 #if (_DEBUG > 0)
-			if (millis() - t0 > 1000)
-			{
-				if (gps.satellites > last_satellites)
-				{
-					Serial.print(gps.satellites);
-					last_satellites = gps.satellites;
-				}
-				else if (gps.ss % 10 == 0)
-				{
-					Serial.print(gps.ss);
-				}
-				else
-				{
-					Serial.print(".");
-				}
-				t0 = millis();
-			}
+			Serial.println(F("WWVB time corrected from GPS"));
 #endif
 		}
-
+#if (HOLDOVER_RTC == 1)
+		// the GPS has taken over, keep the RTC on its time (on the first fix, then hourly)
+		if (sync_gpstime | (gps.mm == 0))
+		{
+			rtc.write(gps.hh, gps.mm, gps.ss, gps.DD, gps.MM, gps.YY);
+		}
+		holdover = false;
+#endif
+		sync_gpstime = false;
+#else
+#if (GPS_SERIAL == 0)
 		// disable the pin change interrupts that SoftwareSerial uses to read data
 		// as it interferes with the wwvb timing
 		ttl.stopListening();
 		disableSoftwareSerialRead(); // disable SoftwareSerial pin change interrupts
+#endif
 
-		// Yeah im ignoring the last parameter to set whether we are in daylight savings time
-		wwvb_tx.set_time(gps.hh, gps.mm, gps.DD, gps.MM, gps.YY);
-		wwvb_tx.start();
+		// the clock keeps the local time for the display/schedule, wwvb_tx ticks it while transmitting
+		wwvb_tx.clock.set(gps.hh, gps.mm, gps.ss, gps.DD, gps.MM, gps.YY);
+
+		// the DST bits come from DST_RULE, worked out by wwvb_tx for every minute
+		bool synced = transmitWindow(gps.hh, gps.mm, gps.ss);
+		if (synced)
+		{
+			wwvb_tx.set_time(gps.hh, gps.mm, gps.DD, gps.MM, gps.YY);
+			wwvb_tx.start();
+		}
+#if (TX_SCHEDULE == 1)
+		synced |= schedule.is_standby(); // otherwise warming up, try again on the next 0s sentence
+#endif
 
 #if (_DEBUG > 0)
-		// get the time from gps
-		uint8_t hh = gps.hh;
-		uint8_t mm = gps.mm;
-		uint8_t ss = gps.ss;
-		uint8_t DD = gps.DD;
-		uint8_t MM = gps.MM;
-		uint8_t YY = gps.YY;
-		
-		// Display as local time (ACDT = UTC+10:30)
-		addTimezone<uint8_t>(hh, mm, ss, DD, MM, YY, 10, 30, 0);
+		// local time (e.g. ACDT = UTC+10:30)
+		uint8_t hh, mm, ss, DD, MM, YY;
+		wwvb_tx.clock.get(hh, mm, ss, DD, MM, YY);
 		
 		Serial.println("");
 		Serial.println(F("##### GPS SYNCED #####"));
@@ -326,13 +756,35 @@ void loop()
 		Serial.print(F("Quality    : ")); Serial.println(gps.quality);
 		Serial.print(F("Satellites : ")); Serial.println(gps.satellites);
 		Serial.print(F("Time/Date  : ")); print_datetime(hh, mm, DD, MM, YY);
-		Serial.println(F("WWVB transmit started"));
+		Serial.println(wwvb_tx.is_active() ? F("WWVB transmit started") : F("WWVB outside the transmit windows"));
 #endif
-		sync_gpstime = false;
+		if (synced)
+		{
+			sync_gpstime = false;
+			gpsPower(false); // not needed until the next resync
+		}
+#endif
+	}
+#if (HOLDOVER_RTC == 1)
+	else if (sync_gpstime & !wwvb_tx.is_active())
+	{
+		holdoverStart();
 	}
+#endif
+}
 
+// Sync supervision task : the resync cycle and the transmit windows
+void taskSync()
+{
+#if (CONTINUOUS_TX == 0)
 	if (!sync_gpstime)
 	{
+		// power the GPS up a minute before the resync so it has a fix when it is needed
+		if ((wwvb_tx.mm() % 10 == 8) & wwvb_tx.is_active())
+		{
+			gpsPower(true);
+		}
+
 		// Note
 		// * wwvb time is synced and wwvb transmission is started when minutes = 0,10,20,30,40 or 50
 		// * wwvb transmission is stopped when minutes = 9,19,29,39,49 or 59
@@ -342,56 +794,131 @@ void loop()
 		if ((wwvb_tx.mm() % 10 == 9) & wwvb_tx.is_active())
 		{
 			wwvb_tx.stop();
-			sync_gpstime = true;
+			startSync();
 #if (_DEBUG > 0)
 			Serial.println(F("WWVB transmit stopped\nResyncing time with GPS"));
 #endif
 		}
 	}
+#endif
 
-#if (_DEBUG > 0)
-	if (mins != wwvb_tx.mm())
+#if (TX_SCHEDULE == 1)
+	// stop at the end of a transmit window
+	if (wwvb_tx.is_active() & (wwvb_tx.ss() == 0))
 	{
-		// get the time from gps
-		uint8_t hh = wwvb_tx.hh();
-		uint8_t mm = wwvb_tx.mm();
-		uint8_t ss = wwvb_tx.ss();
-		uint8_t DD = wwvb_tx.DD();
-		uint8_t MM = wwvb_tx.MM();
-		uint8_t YY = wwvb_tx.YY();
-		
-		// Convert wwvb time transmitted time to local time
-		addTimezone<uint8_t>(hh, mm, ss, DD, MM, YY, wwvb_timezone[0], wwvb_timezone[1], 0);
-			
-		Serial.print(F("Time/Date  : ")); print_datetime(hh, mm, DD, MM, YY);
-		mins = wwvb_tx.mm();
+		uint8_t hh, mm, ss, DD, MM, YY;
+		wwvb_tx.clock.get(hh, mm, ss, DD, MM, YY); // local time
+		if (!transmitWindow(hh, mm, ss) & !schedule.is_standby())
+		{
+			// the next window is within the warmup, stay synced to the GPS until it opens
+			gpsPower(true);
+			startSync();
+		}
+	}
+
+	// resync with the GPS ahead of the next window
+	if (schedule.wake())
+	{
+		gpsPower(true);
+		startSync();
 	}
 #endif
+}
 
-	// Debug LED
-	if (wwvb_tx.is_active())
+// Debug LED task : blinks every slot (100ms) while transmitting, every second while there are no satellites
+void taskLED()
+{
+	static uint8_t slots = 0;
+	if (wwvb_tx.is_active() | ((gps.satellites == 0) & (++slots >= WWVB_TASK_SLOTS)))
 	{
-		if (millis() - t0 >= LED_FAST)
-		{
-			t0 = millis();
-			digitalWrite(LED_PIN, LED_TOGGLE);
-			LED_TOGGLE = !LED_TOGGLE;
-		}
+		slots = 0;
+		digitalWrite(LED_PIN, LED_TOGGLE);
+		LED_TOGGLE = !LED_TOGGLE;
 	}
-	else
+	else if (gps.satellites > 0)
 	{
-		if (gps.satellites == 0)
+		digitalWrite(LED_PIN, HIGH);
+	}
+}
+
+#if (_DEBUG > 0)
+// Debug task, once a second : the GPS progress while syncing, the time and the stats every minute
+void taskDebug()
+{
+#if (CONTINUOUS_TX == 0)
+	if (sync_gpstime)
+	{
+		if (gps.satellites > last_satellites)
 		{
-			if (millis() - t0 >= SLOW_DELAY)
-			{
-				t0 = millis();
-				digitalWrite(LED_PIN, LED_TOGGLE);
-				LED_TOGGLE = !LED_TOGGLE;
-			}
+			Serial.print(gps.satellites);
+			last_satellites = gps.satellites;
+		}
+		else if (gps.ss % 10 == 0)
+		{
+			Serial.print(gps.ss);
 		}
 		else
 		{
-			digitalWrite(LED_PIN, HIGH);
+			Serial.print(".");
 		}
+		return;
 	}
-}
\ No newline at end of file
+#endif
+	if (mins != wwvb_tx.mm())
+	{
+		// local time
+		uint8_t hh, mm, ss, DD, MM, YY;
+		wwvb_tx.clock.get(hh, mm, ss, DD, MM, YY);
+
+		Serial.print(F("Time/Date  : ")); print_datetime(hh, mm, DD, MM, YY);
+#if (WWVB_ISR_STATS == 1)
+		wwvb_tx.print_stats(Serial);
+		wwvb_tx.reset_stats();
+#endif
+#if (WWVB_LOOPBACK == 1)
+		wwvb_tx.print_loopback(Serial);
+#endif
+#if (WWVB_DRIFT == 1)
+		wwvb_tx.print_drift(Serial);
+#endif
+		tasks.print_stats(Serial);
+		tasks.reset_stats();
+		mins = wwvb_tx.mm();
+	}
+}
+#endif
+
+#if (WWVB_STATUS == 1)
+// Status task, every 10s half way through the second : one binary frame, ~42 bytes into the Serial buffer
+void taskStatus()
+{
+	uint8_t flags = gps.IsValid ? WWVB_STATUS_VALID : 0;
+#if (HOLDOVER_RTC == 1)
+	flags |= holdover ? WWVB_STATUS_HOLDOVER : 0;
+#endif
+	status.send(Serial, gps.quality, gps.satellites, flags);
+}
+#endif
+
+// Foreground tasks (see wwvb_tasks.h), period / phase in 100ms slots of the transmitted second
+// * the GPS parser and the frame encoder run on every slice
+// * the supervision and the LED every slot, the debug output once a second, the status frame every 10s
+const wwvb_task tasks_table[] PROGMEM = {
+	{ taskGPS, 0, 0, 2 },
+	{ updateFrame, 0, 0, 5 },
+	{ taskSync, 1, 0, 1 },
+	{ taskLED, 1, 0, 1 },
+#if (_DEBUG > 0)
+	{ taskDebug, WWVB_TASK_SLOTS, 0, 10 },
+#endif
+#if (WWVB_STATUS == 1)
+	{ taskStatus, 10 * WWVB_TASK_SLOTS, 5, 5 },
+#endif
+	};
+wwvb_tasks tasks(tasks_table, sizeof(tasks_table) / sizeof(tasks_table[0]), wwvb_tx.clock);
+
+void loop()
+{
+	tasks.run();
+	idle();
+}
@@ -138,6 +138,7 @@ uint32_t t0;
 #define REQUIRE_TIMEDATESTRING 1
 
 #include <TimeDateTools.h> // include before wwvb.h AND/OR ATtinyGPS.h
+#include <date_table.h> // date_add(), table driven addTimezone()
 #include <wwvb.h> // include before ATtinyGPS.h
 wwvb wwvb_tx;
 
@@ -149,10 +150,32 @@ ISR(TIMER1_OVF_vect)
 
 const int8_t wwvb_timezone[2] = {-6, 0};
 
+// SLEEP_IDLE 1 : idle the CPU between interrupts, Timer1 keeps generating the carrier
+#define SLEEP_IDLE 1
+
+#include <avr/sleep.h>
+#include <avr/power.h>
+
+void idle()
+{
+#if (SLEEP_IDLE == 1)
+   // wakes on the next interrupt (Timer1 overflow, millis())
+   set_sleep_mode(SLEEP_MODE_IDLE);
+   sleep_enable();
+   sleep_cpu();
+   sleep_disable();
+#endif
+}
+
 void setup()
 {
    wwvb_tx.setup();
 
+   // nothing uses the ADC or analog comparator
+   ADCSRA = 0;
+   power_adc_disable();
+   ACSR |= _BV(ACD);
+
    // Note: set the timezone before you set your time
 
    // if you are using CST (UTC -6:00), set the timezone to +6,0
@@ -197,7 +220,7 @@ void loop()
 		uint8_t YY = wwvb_tx.YY();
 				
 		// Convert wwvb time transmitted time to local time
-		addTimezone<uint8_t>(hh, mm, ss, DD, MM, YY, wwvb_timezone[0], wwvb_timezone[1], 0);
+		date_add<uint8_t>(hh, mm, ss, DD, MM, YY, wwvb_timezone[0], wwvb_timezone[1], 0);
 		
 		mins = wwvb_tx.mm();
 	}
@@ -216,4 +239,6 @@ void loop()
    {
       digitalWrite(LED_PIN, HIGH);
    }
+
+   idle();
 }
\ No newline at end of file
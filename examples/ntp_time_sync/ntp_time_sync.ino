@@ -0,0 +1,278 @@
+#include <Arduino.h>
+//ESP32 DevKit (headless, no GPS or antenna for the time, only Wi-Fi)
+//          +--------------+
+//          | EN       D23 |
+//          | VP       D22 |
+//          | VN       TX0 |
+//          | D34      RX0 |
+//          | D35      D21 |
+//          | D32      D19 |
+//          | D33      D18 |
+//    WWVB <= D25       D5 |
+//          | D26      TX2 |
+//          | D27      RX2 |
+//          | D14       D4 |
+//          | D12       D2 | => LED
+//          | D13      D15 |
+//          | GND      GND |
+//          | VIN      3V3 |
+//          +-----USB------+
+
+/*
+Syncs the transmitter from an NTP server (ntp_time.h) instead of a GPS, the carrier is the
+ESP32 LEDC (wwvb_ledc.h). The first frame goes out on the first 0s second after the first
+NTP reply, i.e. within a minute of the Wi-Fi connecting, there is no cold start.
+
+The time source is read by syncTime(), the same code takes any source with the GPS fields
+(hh, mm, ss, DD, MM, YY, IsValid, new_data()) : nmea_time, ATtinyGPS or ntp_time.
+
+Recommended debug setup
+Use a RC (low-pass) filter to view the message (p1) as well as the modulated carrier (p0)
+
+WWVB_OUT |--(p0)--[110R]--(p1)--[1uF]--|GND
+
+-----------+---------------+-----------------
+Chip       | #define       | WWVB_OUT
+-----------+---------------+-----------------
+ESP32      | WWVB_LEDC_PIN | *GPIO 25
+-----------+---------------+-----------------
+
+* Default setup
+*/
+
+#if !defined(ESP32)
+#error ntp_time_sync : ESP32 only (the ESP8266 has no hardware PWM for the carrier)
+#endif
+
+#define _DEBUG 1
+
+/*
+_DEBUG == 0: no serial output
+_DEBUG == 1: serial output, the NTP sync and the stats every minute
+*/
+
+#define LED_PIN 2
+
+bool LED_TOGGLE = false;
+uint8_t mins = 0;
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+// Your network and the NTP server, a local one (e.g. the router) has the least round trip
+#define WIFI_SSID "ssid"
+#define WIFI_PASSWORD "password"
+#define NTP_SERVER "pool.ntp.org"
+
+// Loopback self check, the ISR traces what it emitted and wwvb_tx.update() decodes it like a clock
+// 0 = off
+// 1 = on (240 bytes of RAM)
+#define WWVB_LOOPBACK 0
+// Resync drift telemetry, the transmitted second is timed against the NTP second every minute
+// and the rate error of the esp_timer is taken out of the calibration (see wwvb_frame.h)
+// 0 = off
+// 1 = on
+#define WWVB_DRIFT 1
+// Reduced power level, pulse width in percent of the high level
+// 0 = carrier off (most clocks decode this fine)
+// WWVB_PWM_LOW_TRUE = the level of the real transmitter, WWVB -17dB (DCF77 15%, JJY 10%, MSF off)
+#define WWVB_PWM_LOW 0
+#define WWVB_LEDC_PIN 25
+#include <wwvb_frame.h> // wwvb_ledc is the carrier timer on the ESP32
+#include <wwvb_tasks.h>
+#include <ntp_time.h>
+
+// Time code standard, the signal your clock is built for (see timecode.h)
+// TIMECODE_WWVB, TIMECODE_DCF77, TIMECODE_JJY40, TIMECODE_JJY60, TIMECODE_MSF or TIMECODE_BPC
+// Note : set wwvb_timezone to the time the clock expects e.g. DCF77 = UTC+1, JJY = UTC+9, BPC = UTC+8
+// Note : no TIMECODE_ROUND_ROBIN, the LEDC carrier is set once
+#define TIMECODE TIMECODE_WWVB
+timecode_tx<TIMECODE> wwvb_tx;
+
+// The esp_timer tick, every 1ms (see wwvb_ledc.h)
+void wwvb_tick()
+{
+	wwvb_tx.interrupt_routine();
+}
+
+// Daylight saving time rule for the DST bits, evaluated every minute on the local time (see timecode_dst.h)
+#define DST_RULE TIMECODE_DST_NONE
+
+WiFiUDP udp;
+ntp_time ntp;
+extern wwvb_tasks tasks; // the task table is below the tasks, before loop()
+
+// Binary status frames for remote monitoring (see wwvb_status.h), every 10s
+// 0 = off
+// 1 = on Serial
+// 2 = on Serial and a UDP packet to WWVB_STATUS_HOST : WWVB_STATUS_PORT (the fleet collector)
+#define WWVB_STATUS 2
+#define WWVB_STATUS_HOST "192.168.1.10"
+#define WWVB_STATUS_PORT 5757
+
+#if (WWVB_STATUS > 0)
+#include <wwvb_status.h>
+wwvb_status<decltype(wwvb_tx)> status(wwvb_tx);
+#endif
+
+const int8_t local_timezone[2] = {10, 30};
+const int8_t wwvb_timezone[2] = {-6, 0};
+
+void setup()
+{
+	// set the timezone before you set your time
+	ntp.setTimezone(local_timezone[0], local_timezone[1]); // set this to your local time e.g. (ACDT = UTC +10:30)
+
+	// if you are using CST (UTC -6:00), set the timezone to +6,0
+	wwvb_tx.setTimezone(-wwvb_timezone[0], -wwvb_timezone[1]);
+	wwvb_tx.set_dst_rule(DST_RULE);
+	wwvb_tx.set_dut1(0);
+	wwvb_tx.set_leap_second(0, 0); // none announced
+
+	wwvb_ledc::attach(wwvb_tick);
+	wwvb_tx.setup();
+	// one ms a second is 1000ppm, the drift brings it in from the NTP seconds
+	wwvb_tx.calibrate(0);
+#if (WWVB_DRIFT == 1)
+	wwvb_tx.set_drift_auto(true);
+#endif
+
+#if (_DEBUG > 0) | (WWVB_STATUS > 0)
+	Serial.begin(115200);
+#endif
+#if (_DEBUG > 0)
+	Serial.print(F("LEDC carrier : ")); Serial.println(wwvb_ledc::carrier_hz());
+#endif
+
+	pinMode(LED_PIN, OUTPUT);
+
+	WiFi.mode(WIFI_STA);
+	WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+	ntp.begin(udp);
+}
+
+// Sync from a time source on its 0s second : start the transmitter, then correct it if it has drifted
+// second_us : micros() at the start of the source second, for the drift
+template <typename SOURCE>
+void syncTime(SOURCE &source, const uint32_t second_us)
+{
+	if (!(source.new_data() & (source.ss == 0) & source.IsValid))
+	{
+		return;
+	}
+#if (WWVB_DRIFT == 1)
+	wwvb_tx.drift(date_to_seconds(source.hh, source.mm, source.ss, source.DD, source.MM, source.YY), second_us);
+#endif
+#if (WWVB_STATUS > 0)
+	status.synced();
+#endif
+	if (!wwvb_tx.is_active())
+	{
+		wwvb_tx.clock.set(source.hh, source.mm, source.ss, source.DD, source.MM, source.YY);
+		wwvb_tx.set_time(source.hh, source.mm, source.DD, source.MM, source.YY);
+		wwvb_tx.start();
+#if (_DEBUG > 0)
+		Serial.print(F("WWVB transmit started, NTP stratum ")); Serial.print(ntp.stratum);
+		Serial.print(F(", round trip ")); Serial.print(ntp.delay_us()); Serial.println(F(" us"));
+#endif
+	}
+	else if (wwvb_tx.sync_time(source.hh, source.mm, source.DD, source.MM, source.YY))
+	{
+#if (_DEBUG > 0)
+		Serial.println(F("WWVB time corrected from NTP"));
+#endif
+	}
+}
+
+// NTP task : every slice, the reply is timestamped when it is read
+void taskNTP()
+{
+	if (WiFi.status() != WL_CONNECTED)
+	{
+		return; // the transmitter freewheels on the last sync
+	}
+	ntp.poll(udp, NTP_SERVER);
+	syncTime(ntp, ntp.second_us());
+}
+
+// Encode the next minute's frame
+void updateFrame()
+{
+	wwvb_tx.update();
+}
+
+// Debug LED task : blinks every slot (100ms) while transmitting, on while waiting for NTP
+void taskLED()
+{
+	if (wwvb_tx.is_active())
+	{
+		digitalWrite(LED_PIN, LED_TOGGLE);
+		LED_TOGGLE = !LED_TOGGLE;
+	}
+	else
+	{
+		digitalWrite(LED_PIN, HIGH);
+	}
+}
+
+#if (_DEBUG > 0)
+// Debug task, once a second : the time and the stats every minute
+void taskDebug()
+{
+	if (mins != wwvb_tx.mm())
+	{
+		// local time
+		uint8_t hh, mm, ss, DD, MM, YY;
+		wwvb_tx.clock.get(hh, mm, ss, DD, MM, YY);
+
+		Serial.print(F("Time/Date  : "));
+		Serial.print(hh); Serial.print(':'); Serial.print(mm); Serial.print(' ');
+		Serial.print(DD); Serial.print('/'); Serial.print(MM); Serial.print('/'); Serial.println(YY);
+#if (WWVB_LOOPBACK == 1)
+		wwvb_tx.print_loopback(Serial);
+#endif
+#if (WWVB_DRIFT == 1)
+		wwvb_tx.print_drift(Serial);
+#endif
+		tasks.print_stats(Serial);
+		tasks.reset_stats();
+		mins = wwvb_tx.mm();
+	}
+}
+#endif
+
+#if (WWVB_STATUS > 0)
+// Status task, every 10s half way through the second : quality is 1 while the NTP time is valid, satellites the stratum
+void taskStatus()
+{
+	const uint8_t flags = ntp.IsValid ? WWVB_STATUS_VALID : 0;
+	status.send(Serial, ntp.IsValid ? 1 : 0, ntp.stratum, flags);
+#if (WWVB_STATUS == 2)
+	if (WiFi.status() == WL_CONNECTED)
+	{
+		udp.beginPacket(WWVB_STATUS_HOST, WWVB_STATUS_PORT);
+		status.send(udp, ntp.IsValid ? 1 : 0, ntp.stratum, flags);
+		udp.endPacket();
+	}
+#endif
+}
+#endif
+
+// Foreground tasks (see wwvb_tasks.h), period / phase in 100ms slots of the transmitted second
+const wwvb_task tasks_table[] PROGMEM = {
+	{ taskNTP, 0, 0, 2 },
+	{ updateFrame, 0, 0, 5 },
+	{ taskLED, 1, 0, 1 },
+#if (_DEBUG > 0)
+	{ taskDebug, WWVB_TASK_SLOTS, 0, 10 },
+#endif
+#if (WWVB_STATUS > 0)
+	{ taskStatus, 10 * WWVB_TASK_SLOTS, 5, 5 },
+#endif
+	};
+wwvb_tasks tasks(tasks_table, sizeof(tasks_table) / sizeof(tasks_table[0]), wwvb_tx.clock);
+
+void loop()
+{
+	tasks.run();
+}
@@ -0,0 +1,532 @@
+#!/usr/bin/env python3
+"""
+footprint : flash / SRAM / stack budget of the examples, per board and feature option
+
+Builds every example (minimum, gps_time_sync, gps_time_sync_nokia5110) with arduino-cli
+for the ATtiny85, the 328p (Nano) and the 32u4 (Micro), once per variant of the
+#define options at the top of the sketch (a copy of the sketch is edited, the repo is
+left alone), and reports
+* flash and SRAM (.data + .bss + .noinit) of each build, and the change against the
+  default options on the same board, i.e. what a feature costs
+* the largest flash and SRAM symbols of each build (avr-nm)
+* the worst case stack depth : the deepest call chain from main() plus the deepest
+  interrupt (they don't nest), from the -fstack-usage frame of each function and the
+  call graph of the disassembly (avr-objdump), and the SRAM that is left
+A variant the sketch rejects with #error (e.g. WWVB_ISR_STATS on the ATtiny85) is listed
+as n/a with the message.
+
+The sizes are the shipped build (LTO, as the IDE builds it). The stack is from a second
+build with -fstack-usage -fno-lto, the frames are only written without LTO, the library
+is header only so the inlining is nearly the same. The stack figure is static :
+* an icall (a function pointer, e.g. the wwvb_tasks table, a virtual Print::write()) is
+  taken as a call of the deepest function that has no direct caller
+* a function with no frame size (libgcc / libc assembly) counts as 0 bytes, the report
+  lists how many there were
+* recursion is flagged, the cycle is counted once
+Leave a margin, the interrupt entry and the libc routines add a few bytes.
+
+The exit code is the number of builds that failed or don't fit (flash over the board
+maximum or the static SRAM plus the stack over the RAM), so it can gate a change.
+
+Needs arduino-cli with the arduino:avr core, ATTinyCore (ATtiny85) and the libraries
+of the sketches (TimeDateTools, ATtinyGPS, Adafruit GFX / PCD8544). avr-size, avr-nm
+and avr-objdump are found on the PATH or in the arduino-cli packages (--tools).
+
+Usage :
+	python3 footprint.py [--sketch NAME] [--board attiny85|328p|32u4] [--variant TEXT] [--top N] [--out FILE]
+	python3 footprint.py --list
+e.g. the cost of each gps_time_sync option on the 328p, with 20 symbols a build
+	python3 footprint.py --sketch gps_time_sync --board 328p --top 20 --out footprint.md
+"""
+
+import argparse
+import bisect
+import concurrent.futures
+import glob
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+REPO = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+
+# name : fqbn, flash bytes (less the bootloader), RAM bytes
+BOARDS = {
+	'attiny85': ('ATTinyCore:avr:attinyx5:chip=85,clock=8internal', 8192, 512),
+	'328p': ('arduino:avr:nano:cpu=atmega328', 30720, 2048),
+	'32u4': ('arduino:avr:micro', 28672, 2560),
+}
+
+RETURN_ADDRESS = 2 # bytes a call pushes, all the boards have < 128K flash
+
+# Variants : name, {define : value}[, only on these boards], a value can be {board : value} (None : the other boards)
+# The default variant of a sketch is the reference for the differences
+SKETCHES = [
+	('minimum', 'examples/minimum', ['attiny85', '328p', '32u4'], [
+		('default', {}),
+		('_DEBUG 0', {'_DEBUG': '0'}),
+		('SLEEP_IDLE 0', {'SLEEP_IDLE': '0'}),
+	]),
+	('gps_time_sync', 'examples/gps_time_sync', ['attiny85', '328p', '32u4'], [
+		('default', {}),
+		('_DEBUG 0', {'_DEBUG': '0'}),
+		('WWVB_DRIFT 0', {'WWVB_DRIFT': '0'}),
+		('WWVB_LOOPBACK 1', {'WWVB_LOOPBACK': '1'}),
+		('WWVB_ISR_STATS 1', {'WWVB_ISR_STATS': '1'}),
+		('WWVB_CALIBRATION 1', {'WWVB_CALIBRATION': '1'}),
+		('WWVB_TIMER 2', {'WWVB_TIMER': '2'}),
+		('WWVB_PWM_LOW 15', {'WWVB_PWM_LOW': '15'}),
+		('TIMECODE_DCF77', {'TIMECODE': 'TIMECODE_DCF77'}),
+		('TIMECODE_ROUND_ROBIN', {'TIMECODE': 'TIMECODE_ROUND_ROBIN'}),
+		('DST_RULE US', {'DST_RULE': 'TIMECODE_DST_US'}),
+		('GPS_PARSER ATtinyGPS', {'GPS_PARSER': '0'}),
+		('GPS_PARSER nmea_time', {'GPS_PARSER': '1'}),
+		('GPS_PPS_PIN 3', {'GPS_PPS_PIN': '3'}, ['328p', '32u4']),
+		('GPS_SERIAL uart', {'GPS_SERIAL': {'attiny85': '3', None: '2'}, '_DEBUG': {'328p': '0'}}),
+		('CONTINUOUS_TX 1', {'GPS_SERIAL': {'attiny85': '3', None: '2'}, '_DEBUG': {'328p': '0'}, 'CONTINUOUS_TX': '1'}),
+		('HOLDOVER_RTC 1', {'GPS_SERIAL': {'attiny85': '3', None: '2'}, '_DEBUG': {'328p': '0'}, 'CONTINUOUS_TX': '1', 'HOLDOVER_RTC': '1'}),
+		('WWVB_STATUS 1', {'WWVB_STATUS': '1'}),
+		('TX_SCHEDULE 1', {'TX_SCHEDULE': '1'}),
+		('GPS_POWER_PIN 8', {'GPS_POWER_PIN': '8'}, ['328p', '32u4']),
+		('SLEEP_IDLE 0', {'SLEEP_IDLE': '0'}),
+		('all telemetry', {'WWVB_LOOPBACK': '1', 'WWVB_ISR_STATS': '1', 'WWVB_STATUS': '1'}),
+	]),
+	('gps_time_sync_nokia5110', 'gps_time_sync_nokia5110', ['328p', '32u4'], [
+		('default', {}),
+		('GPS_MODULE mediatek', {'GPS_MODULE': '1'}),
+		('LCD_DRIVER pcd8544_text', {'LCD_DRIVER': '1'}),
+		('_DEBUG 1', {'_DEBUG': '1'}),
+		('WWVB_DRIFT 0', {'WWVB_DRIFT': '0'}),
+		('WWVB_LOOPBACK 1', {'WWVB_LOOPBACK': '1'}),
+		('WWVB_ISR_STATS 1', {'WWVB_ISR_STATS': '1'}),
+		('WWVB_CALIBRATION 1', {'WWVB_CALIBRATION': '1'}),
+		('GPS_SERIAL uart', {'GPS_SERIAL': '2'}),
+		('CONTINUOUS_TX 1', {'GPS_SERIAL': '2', 'CONTINUOUS_TX': '1'}),
+		('HOLDOVER_RTC 1', {'GPS_SERIAL': '2', 'CONTINUOUS_TX': '1', 'HOLDOVER_RTC': '1'}),
+		('TX_SCHEDULE 1', {'TX_SCHEDULE': '1'}),
+	]),
+]
+
+
+def log(*text):
+	print(*text, file=sys.stderr, flush=True)
+
+
+# The defines of a variant for a board
+def variant_defines(defines, board):
+	out = {}
+	for name, value in defines.items():
+		if isinstance(value, dict):
+			value = value.get(board, value.get(None))
+			if value is None:
+				continue
+		out[name] = value
+	return out
+
+
+# Every (uncommented) #define NAME line is set, also the per chip ones, e.g. _DEBUG
+def apply_defines(source, defines):
+	for name, value in defines.items():
+		pattern = re.compile(r'^#define %s(\s.*)?$' % re.escape(name), re.MULTILINE)
+		source, n = pattern.subn('#define %s %s' % (name, value), source)
+		if n == 0:
+			raise KeyError('no #define %s in the sketch' % name)
+	return source
+
+
+def find_tools(tools_dir):
+	dirs = [tools_dir] if tools_dir else []
+	dirs += os.environ.get('PATH', '').split(os.pathsep)
+	data = os.path.expanduser('~/.arduino15')
+	try:
+		out = subprocess.run(['arduino-cli', 'config', 'get', 'directories.data'], capture_output=True, text=True).stdout.strip()
+		if out:
+			data = out
+	except OSError:
+		pass
+	dirs += sorted(glob.glob(os.path.join(data, 'packages', '*', 'tools', 'avr-gcc', '*', 'bin')), reverse=True)
+	tools = {}
+	for tool in ('avr-size', 'avr-nm', 'avr-objdump'):
+		for d in dirs:
+			path = os.path.join(d, tool)
+			if os.path.isfile(path) and os.access(path, os.X_OK):
+				tools[tool] = path
+				break
+		else:
+			raise SystemExit('footprint : %s not found, set --tools to the avr-gcc bin directory' % tool)
+	return tools
+
+
+def run(cmd):
+	return subprocess.run(cmd, capture_output=True, text=True)
+
+
+# Compile a copy of the sketch with the defines, returns (elf path or None, stderr)
+def compile_sketch(cli, sketch_dir, defines, fqbn, build_dir, properties):
+	name = os.path.basename(sketch_dir)
+	copy = os.path.join(build_dir, 'src', name)
+	shutil.rmtree(copy, ignore_errors=True)
+	shutil.copytree(os.path.join(REPO, sketch_dir), copy)
+	ino = os.path.join(copy, name + '.ino')
+	with open(ino) as f:
+		source = f.read()
+	with open(ino, 'w') as f:
+		f.write(apply_defines(source, defines))
+	out = os.path.join(build_dir, 'build')
+	cmd = [cli, 'compile', '--fqbn', fqbn, '--build-path', out, '--library', REPO, '--warnings', 'none']
+	for p in properties:
+		cmd += ['--build-property', p]
+	result = run(cmd + [copy])
+	elf = os.path.join(out, name + '.ino.elf')
+	return (elf if result.returncode == 0 and os.path.isfile(elf) else None), result.stdout + result.stderr
+
+
+# The reason a build failed : ('n/a', the #error text), ('overflow', bytes) or ('failed', the first error)
+def build_error(text):
+	m = re.search(r'#error\s+(.*)', text)
+	if m:
+		return 'n/a', m.group(1).strip()
+	m = re.search(r"region [`'.]?text'? overflowed by (\d+) bytes", text)
+	if m:
+		return 'overflow', int(m.group(1))
+	for line in text.splitlines():
+		if 'error' in line.lower():
+			return 'failed', line.strip()
+	return 'failed', text.strip().splitlines()[-1] if text.strip() else 'no output'
+
+
+# avr-size -A : flash = .text + .data, SRAM = .data + .bss + .noinit
+def parse_size(text):
+	sections = {}
+	for line in text.splitlines():
+		m = re.match(r'^(\.\w+)\s+(\d+)\s+\d+', line)
+		if m:
+			sections[m.group(1)] = int(m.group(2))
+	flash = sections.get('.text', 0) + sections.get('.data', 0)
+	sram = sections.get('.data', 0) + sections.get('.bss', 0) + sections.get('.noinit', 0)
+	return flash, sram
+
+
+# avr-nm -C -S --size-sort : ([(size, name)] flash, [(size, name)] SRAM), largest first
+def parse_nm(text):
+	flash, sram = [], []
+	for line in text.splitlines():
+		m = re.match(r'^[0-9a-fA-F]+\s+([0-9a-fA-F]+)\s+(\w)\s+(.*)$', line)
+		if not m:
+			continue
+		size, kind, name = int(m.group(1), 16), m.group(2), m.group(3)
+		if kind in 'TtWw':
+			flash.append((size, name))
+		elif kind in 'DdBbVv':
+			sram.append((size, name))
+			if kind in 'Dd':
+				flash.append((size, name + ' (init)'))
+	flash.sort(reverse=True)
+	sram.sort(reverse=True)
+	return flash, sram
+
+
+# The function a .su line / a disassembly label names, without the return type, the
+# template and function arguments and the clone suffix, e.g. timecode_tx::interrupt_routine
+def base_name(name):
+	name = re.sub(r'\s*\[(with|clone) [^\]]*\]', '', name)
+	name = re.sub(r'\.(constprop|isra|part|cold|lto_priv)\.\d+', '', name)
+	name = name.replace('operator()', 'operator@')
+	out, depth = [], 0
+	for ch in name:
+		if ch == '<':
+			depth += 1
+		elif ch == '>' and depth > 0:
+			depth -= 1
+		elif depth == 0:
+			out.append(ch)
+	name = ''.join(out).split('(')[0].strip()
+	return name.split(' ')[-1].replace('operator@', 'operator()')
+
+
+# -fstack-usage files : {base name : (bytes, dynamic)}, overloads and clones take the largest
+def parse_su(paths):
+	frames = {}
+	for path in paths:
+		with open(path) as f:
+			for line in f:
+				parts = line.rstrip('\n').split('\t')
+				if len(parts) < 3:
+					continue
+				name = base_name(parts[0].split(':', 3)[-1])
+				size, dynamic = int(parts[1]), parts[2] != 'static'
+				old = frames.get(name, (0, False))
+				frames[name] = (max(old[0], size), old[1] | dynamic)
+	return frames
+
+
+# avr-objdump -d -C : {function : [(callee or None for an icall, tail)]}, in text order
+def parse_objdump(text):
+	starts, names, body = [], [], []
+	current = None
+	for line in text.splitlines():
+		m = re.match(r'^([0-9a-f]+) <(.*)>:$', line)
+		if m:
+			current = m.group(2)
+			starts.append(int(m.group(1), 16))
+			names.append(current)
+			body.append([])
+			continue
+		if current is None:
+			continue
+		m = re.match(r'^\s+[0-9a-f]+:\s+(?:[0-9a-f]{2} )+\s*(\w+)(.*)$', line)
+		if m:
+			body[-1].append((m.group(1), m.group(2)))
+	graph = {}
+	for i, name in enumerate(names):
+		edges = []
+		for op, args in body[i]:
+			if op in ('icall', 'eicall'):
+				edges.append((None, False))
+				continue
+			if op not in ('call', 'rcall', 'jmp', 'rjmp'):
+				continue
+			m = re.search(r';\s*0x([0-9a-f]+)', args)
+			if not m:
+				continue
+			target = int(m.group(1), 16)
+			j = bisect.bisect_right(starts, target) - 1
+			if j < 0 or j == i or starts[j] != target:
+				continue # a branch inside the function, or the rcall .+0 of a stack frame
+			edges.append((names[j], op.endswith('jmp')))
+		graph.setdefault(name, []).extend(edges)
+	return graph
+
+
+class stack_depth:
+	"""Worst case stack depth of a call graph, memoised, with the chain kept for the report"""
+
+	def __init__(self, graph, frames):
+		self.graph = graph
+		self.frames = {}
+		self.unknown = set()
+		self.dynamic = set()
+		for name in graph:
+			frame = frames.get(base_name(name))
+			if frame is None:
+				self.unknown.add(name)
+				frame = (0, False)
+			self.frames[name] = frame[0]
+			if frame[1]:
+				self.dynamic.add(name)
+		called = set(callee for edges in graph.values() for callee, _ in edges if callee)
+		self.indirect = [name for name in graph if name not in called and name != 'main'
+			and not name.startswith('__') and not name.startswith('_GLOBAL__')]
+		self.memo = {}
+		self.active = set()
+		self.recursive = set()
+		self._icall = None
+
+	def icall(self):
+		if self._icall is None:
+			self._icall = (0, [])
+			best = (0, ['?'])
+			for name in self.indirect:
+				best = max(best, self.depth(name))
+			self._icall = (best[0], ['(icall) ' + best[1][0]] + best[1][1:])
+		return self._icall
+
+	# (bytes, [chain]) from the entry of name
+	def depth(self, name):
+		if name in self.memo:
+			return self.memo[name]
+		if name in self.active:
+			self.recursive.add(name)
+			return 0, [name + ' (recursive)']
+		self.active.add(name)
+		frame = self.frames.get(name, 0)
+		best = (frame, [name])
+		for callee, tail in self.graph.get(name, []):
+			d, chain = self.icall() if callee is None else self.depth(callee)
+			# a tail jump leaves the frame first, a call pushes the return address on it
+			d = d if tail else frame + RETURN_ADDRESS + d
+			if d > best[0]:
+				best = (d, [name] + chain)
+		self.active.discard(name)
+		self.memo[name] = best
+		return best
+
+	# main() plus the deepest interrupt, (bytes, main chain, isr chain)
+	def worst(self):
+		main = self.depth('main') if 'main' in self.graph else (0, [])
+		isr = (0, [])
+		for name in self.graph:
+			if re.match(r'^__vector_\d+$', name):
+				d, chain = self.depth(name)
+				isr = max(isr, (d + RETURN_ADDRESS, chain))
+		return main[0] + isr[0], main, isr
+
+
+def measure(tools, elf, stack_elf, stack_build, top):
+	r = {}
+	r['flash'], r['sram'] = parse_size(run([tools['avr-size'], '-A', elf]).stdout)
+	r['flash_syms'], r['sram_syms'] = [x[:top] for x in parse_nm(run([tools['avr-nm'], '-C', '-S', '--size-sort', elf]).stdout)]
+	r['stack'] = None
+	if stack_elf:
+		frames = parse_su(glob.glob(os.path.join(stack_build, '**', '*.su'), recursive=True))
+		graph = parse_objdump(run([tools['avr-objdump'], '-d', '-C', stack_elf]).stdout)
+		s = stack_depth(graph, frames)
+		r['stack'], r['main'], r['isr'] = s.worst()
+		r['unknown'] = len(s.unknown)
+		r['recursive'] = sorted(s.recursive)
+		r['dynamic'] = sorted(s.dynamic)
+	return r
+
+
+def build(args, tools, job):
+	sketch, sketch_dir, board, variant, defines = job
+	fqbn, flash_max, ram = BOARDS[board]
+	work = tempfile.mkdtemp(prefix='footprint_')
+	try:
+		result = {'sketch': sketch, 'board': board, 'variant': variant, 'flash_max': flash_max, 'ram': ram}
+		try:
+			defines = variant_defines(defines, board)
+			elf, text = compile_sketch(args.arduino_cli, sketch_dir, defines, fqbn, os.path.join(work, 'size'), [])
+		except KeyError as e:
+			result['error'] = ('failed', str(e.args[0]))
+			return result
+		if not elf:
+			result['error'] = build_error(text)
+			return result
+		stack_elf = None
+		stack_build = os.path.join(work, 'stack', 'build')
+		if not args.no_stack:
+			stack_elf, text = compile_sketch(args.arduino_cli, sketch_dir, defines, fqbn, os.path.join(work, 'stack'), [
+				'compiler.c.extra_flags=-fstack-usage -fno-lto',
+				'compiler.cpp.extra_flags=-fstack-usage -fno-lto',
+				'compiler.c.elf.extra_flags=-fno-lto'])
+			if not stack_elf:
+				log('footprint : %s %s %s : the -fstack-usage build failed, %s' % (sketch, board, variant, build_error(text)[1]))
+		result.update(measure(tools, elf, stack_elf, stack_build, args.top))
+		return result
+	finally:
+		if args.keep:
+			log('footprint : %s %s %s kept in %s' % (sketch, board, variant, work))
+		else:
+			shutil.rmtree(work, ignore_errors=True)
+
+
+def over_budget(r):
+	if 'error' in r:
+		return r['error'][0] != 'n/a'
+	return (r['flash'] > r['flash_max']) | (r['sram'] + (r['stack'] or 0) > r['ram'])
+
+
+def delta(value, ref):
+	return '' if ref is None else '%+d' % (value - ref)
+
+
+def percent(value, limit):
+	return '%d (%d%%)' % (value, round(100.0 * value / limit))
+
+
+def report(results):
+	lines = ['# Footprint', '',
+		'Flash and static SRAM of the shipped (LTO) build, the stack is main() plus the deepest interrupt (see footprint.py).', '',
+		'| Sketch | Board | Variant | Flash | Δ | SRAM | Δ | Stack | Free SRAM |',
+		'|---|---|---|---:|---:|---:|---:|---:|---:|']
+	refs = {}
+	for r in results:
+		key = (r['sketch'], r['board'])
+		if 'error' in r:
+			kind, what = r['error']
+			if kind == 'overflow':
+				cell = 'does not fit, %d bytes over' % what
+			else:
+				cell = '%s : %s' % (kind, what)
+			lines.append('| %s | %s | %s | %s | | | | | |' % (r['sketch'], r['board'], r['variant'], cell))
+			continue
+		if r['variant'] == 'default':
+			refs[key] = r
+		ref = refs.get(key) if r['variant'] != 'default' else None
+		stack = r['stack']
+		free = r['ram'] - r['sram'] - (stack or 0)
+		lines.append('| %s | %s | %s | %s | %s | %s | %s | %s | %s%s |' % (r['sketch'], r['board'], r['variant'],
+			percent(r['flash'], r['flash_max']), delta(r['flash'], ref['flash'] if ref else None),
+			percent(r['sram'], r['ram']), delta(r['sram'], ref['sram'] if ref else None),
+			'' if stack is None else stack, '' if stack is None else free, ' (over)' if over_budget(r) else ''))
+
+	for r in results:
+		if 'error' in r:
+			continue
+		lines += ['', '## %s, %s, %s' % (r['sketch'], r['board'], r['variant']), '']
+		lines += ['| Flash | bytes | SRAM | bytes |', '|---|---:|---|---:|']
+		for i in range(max(len(r['flash_syms']), len(r['sram_syms']))):
+			f = r['flash_syms'][i] if i < len(r['flash_syms']) else ('', '')
+			s = r['sram_syms'][i] if i < len(r['sram_syms']) else ('', '')
+			lines.append('| %s | %s | %s | %s |' % (f[1], f[0], s[1], s[0]))
+		if r['stack'] is not None:
+			lines += ['', 'Stack %d bytes : main() %d, interrupt %d' % (r['stack'], r['main'][0], r['isr'][0]), '',
+				'* main : ' + ' > '.join(r['main'][1]),
+				'* interrupt : ' + ' > '.join(r['isr'][1])]
+			if r['unknown']:
+				lines.append('* %d functions without a frame size (assembly, counted as 0)' % r['unknown'])
+			if r['recursive']:
+				lines.append('* recursive : ' + ', '.join(r['recursive']))
+			if r['dynamic']:
+				lines.append('* dynamic frames (alloca / VLA) : ' + ', '.join(r['dynamic']))
+	return '\n'.join(lines) + '\n'
+
+
+def main():
+	parser = argparse.ArgumentParser(description='flash / SRAM / stack budget of the examples')
+	parser.add_argument('--sketch', action='append', help='only this sketch (repeatable)')
+	parser.add_argument('--board', action='append', choices=sorted(BOARDS), help='only this board (repeatable)')
+	parser.add_argument('--variant', action='append', help='only the variants with this text in the name (repeatable), default is always built')
+	parser.add_argument('--top', type=int, default=10, help='symbols a build in the tables (10)')
+	parser.add_argument('--out', help='markdown report (stdout)')
+	parser.add_argument('--arduino-cli', default='arduino-cli')
+	parser.add_argument('--tools', help='directory of avr-size, avr-nm and avr-objdump')
+	parser.add_argument('--no-stack', action='store_true', help='skip the -fstack-usage build')
+	parser.add_argument('--keep', action='store_true', help='keep the build directories')
+	parser.add_argument('-j', '--jobs', type=int, default=1, help='parallel builds (1)')
+	parser.add_argument('--list', action='store_true', help='list the builds and their defines, build nothing')
+	args = parser.parse_args()
+
+	jobs = []
+	for sketch, sketch_dir, boards, variants in SKETCHES:
+		if args.sketch and sketch not in args.sketch:
+			continue
+		for board in boards:
+			if args.board and board not in args.board:
+				continue
+			for variant in variants:
+				variant, defines, only = (variant + (None,))[:3]
+				if only and board not in only:
+					continue
+				if args.variant and variant != 'default' and not any(v in variant for v in args.variant):
+					continue
+				jobs.append((sketch, sketch_dir, board, variant, defines))
+	if args.list:
+		for sketch, _, board, variant, defines in jobs:
+			print('%s %s %s : %s' % (sketch, board, variant, ' '.join('%s=%s' % d for d in sorted(variant_defines(defines, board).items()))))
+		return 0
+
+	tools = find_tools(args.tools)
+	with concurrent.futures.ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+		futures = [pool.submit(build, args, tools, job) for job in jobs]
+		results = []
+		for job, future in zip(jobs, futures):
+			results.append(future.result())
+			log('footprint : %s %s %s done' % (job[0], job[2], job[3]))
+
+	text = report(results)
+	if args.out:
+		with open(args.out, 'w') as f:
+			f.write(text)
+	else:
+		sys.stdout.write(text)
+	failed = sum(1 for r in results if over_budget(r))
+	log('footprint : %d builds, %d failed or over budget' % (len(results), failed))
+	return failed
+
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,67 @@
+#ifndef HOST_BENCH_ARDUINO_H
+#define HOST_BENCH_ARDUINO_H
+
+/*
+Minimal native (x86) stand in for the Arduino core, just enough for wwvb_frame.h
+
+The Timer1 and Timer2 registers are plain globals so the benchmark can read the compare
+register after every simulated overflow. Single translation unit only.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define _BV(bit) (1U << (bit))
+
+volatile uint16_t ICR1, OCR1A, OCR1B, TCNT1;
+volatile uint8_t TCCR1A, TCCR1B, TIFR1, TIMSK1;
+
+enum
+{
+	WGM10 = 0, WGM11 = 1, COM1B0 = 4, COM1B1 = 5, COM1A0 = 6, COM1A1 = 7, // TCCR1A
+	CS10 = 0, CS11 = 1, CS12 = 2, WGM12 = 3, WGM13 = 4,                    // TCCR1B
+	TOV1 = 0, TOIE1 = 0,                                                   // TIFR1, TIMSK1
+	WGM20 = 0, WGM21 = 1, COM2A0 = 6, COM2A1 = 7, CS20 = 0,                // TCCR2A, TCCR2B
+	OCF2A = 1, OCIE2A = 1                                                  // TIFR2, TIMSK2
+};
+
+volatile uint8_t TCCR2A, TCCR2B, OCR2A, TCNT2, TIFR2, TIMSK2;
+
+#define cli()
+#define sei()
+
+// Simulated time, advanced by the benchmark
+uint32_t host_millis;
+uint32_t host_micros;
+inline uint32_t millis() { return host_millis; }
+inline uint32_t micros() { return host_micros; }
+
+#define OUTPUT 1
+#define INPUT 0
+#define LOW 0
+#define HIGH 1
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+#define F(s) (s)
+
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(const uint8_t c) { return fputc(c, stdout) != EOF; }
+	void print(const char *s) { fputs(s, stdout); }
+	void print(const uint32_t v) { printf("%lu", static_cast<unsigned long>(v)); }
+	void print(const int32_t v) { printf("%ld", static_cast<long>(v)); }
+	void println(const char *s) { puts(s); }
+	void println(const uint32_t v) { printf("%lu\n", static_cast<unsigned long>(v)); }
+};
+
+#endif
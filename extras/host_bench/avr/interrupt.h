@@ -0,0 +1,6 @@
+#ifndef HOST_BENCH_INTERRUPT_H
+#define HOST_BENCH_INTERRUPT_H
+
+// cli() / sei() are in Arduino.h, the benchmark is single threaded
+
+#endif
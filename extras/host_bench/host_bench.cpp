@@ -0,0 +1,1196 @@
+/*
+host_bench : native (x86) frame accuracy and speed benchmark for wwvb_frame.h
+
+Runs wwvb_frame on a simulated Timer1 (one interrupt_routine() call per carrier
+cycle) and reports
+* second, frame and per symbol timing error, against a CPU clock that can be offset by N ppm
+* frame encoding errors, decoding the simulated output against the NIST WWVB format
+* wwvb_tx.clock (epoch_clock.h) against the transmitted minute
+* the loopback self check (WWVB_LOOPBACK) on a clean run and on an interrupt held off for 30ms
+* the second coil (USE_OC1A and USE_OC1B) : OC1B in phase and inverted (H-bridge) at its own reduced power level
+* the WWVB leap second warning for the month of the given time, across a timezone into the next or previous month
+* the Timer2 backend (wwvb_timer2) : frames, second length and carrier frequency of OC2A toggling
+* the resync drift loop (WWVB_DRIFT) trimming out a 300ppm fast resonator against GPS references
+* the PPS discipline (pps_interrupt()) locking the second onto the edge from 3 to 5000 cycles out, and the rate of a 20ppm fast resonator
+* wwvb_status.h : the binary status frame decoded back (layout, checksum, the drift / loopback sections, the uptime across the millis() rollover)
+* wwvb_tasks.h slots : a once a second task in slot 0, one periodic task per slice, overruns and a clock set back
+* nmea_time.h on RMC / GGA sentences : the timezone, other talkers, empty fields before a fix and bad checksums
+* ntp_time.h against a simulated server : the least round trip reply of a burst, stale and kiss-o'-death replies, the freewheeling seconds
+* frame encoding errors for every minute boundary of 2001 - 2098 (wwvb_encode_frame only)
+* timecode_dst.h rules against the published 2024 / 2025 change dates, and the WWVB DST bits on those days
+* date_add() (date_table.h) and addTimezone<>() errors against an independent day count implementation
+* ns/iteration for wwvb_encode_frame(), date_add(), addTimezone<>() and interrupt_routine()
+
+The exit code is the number of failed checks, so it can gate changes before flashing
+
+Build (TimeDateTools is the same library the sketches use) :
+	g++ -O2 -std=c++11 -I. -I../.. -I<path to>/TimeDateTools host_bench.cpp -o host_bench
+
+Usage :
+	./host_bench [minutes = 60] [cpu error ppm = 0] [trim in carrier cycles per second = 0]
+e.g. compare trims for a resonator that is 250ppm slow (the trim is passed to calibrate_q16())
+	./host_bench 30 -250 -15
+	./host_bench 30 -250 -14.98
+*/
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#include <TimeDateTools.h>
+#define USE_OC1A
+#define USE_OC1B
+#define WWVB_LOOPBACK 1
+#define WWVB_DRIFT 1
+#include <wwvb_frame.h>
+#include <wwvb_tasks.h>
+#include <nmea_time.h>
+#include <ntp_time.h>
+#include <wwvb_status.h>
+
+struct date_time
+{
+	uint8_t hh, mm, DD, MM, YY;
+};
+
+/*
+Reference calendar, independent of date_table.h and TimeDateTools
+Days since 2000-01-01 (valid for 2000 - 2099)
+*/
+static int32_t ref_days(const uint8_t DD, const uint8_t MM, const uint8_t YY)
+{
+	static const uint16_t before[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+	int32_t days = 365L * YY + (YY + 3) / 4 + before[MM - 1] + DD - 1;
+	if ((MM > 2) & ((YY % 4) == 0))
+	{
+		++days;
+	}
+	return days;
+}
+
+static bool ref_leap_year(const uint8_t YY)
+{
+	return (YY % 4) == 0;
+}
+
+static uint8_t ref_days_in_month(const uint8_t MM, const uint8_t YY)
+{
+	switch (MM)
+	{
+	case 2: return ref_leap_year(YY) ? 29 : 28;
+	case 4: case 6: case 9: case 11: return 30;
+	}
+	return 31;
+}
+
+static int32_t ref_minutes(const date_time &t)
+{
+	return ref_days(t.DD, t.MM, t.YY) * 1440L + t.hh * 60L + t.mm;
+}
+
+static date_time ref_from_minutes(int32_t minutes)
+{
+	date_time t;
+	int32_t days = minutes / 1440;
+	minutes %= 1440;
+	t.hh = minutes / 60;
+	t.mm = minutes % 60;
+	t.YY = 0;
+	while (days >= (ref_leap_year(t.YY) ? 366 : 365))
+	{
+		days -= ref_leap_year(t.YY) ? 366 : 365;
+		++t.YY;
+	}
+	t.MM = 1;
+	while (days >= ref_days_in_month(t.MM, t.YY))
+	{
+		days -= ref_days_in_month(t.MM, t.YY);
+		++t.MM;
+	}
+	t.DD = days + 1;
+	return t;
+}
+
+static bool same_time(const date_time &a, const date_time &b)
+{
+	return (a.hh == b.hh) & (a.mm == b.mm) & (a.DD == b.DD) & (a.MM == b.MM) & (a.YY == b.YY);
+}
+
+// Deterministic pseudo random numbers (glibc LCG constants) so runs are comparable
+static uint32_t rng_state = 12345;
+static uint32_t rng()
+{
+	rng_state = rng_state * 1103515245UL + 12345UL;
+	return rng_state >> 8;
+}
+
+/*
+Reference decoder : WWVB time code format (NIST Special Publication 432)
+symbols[60] = WWVB_ZERO / WWVB_ONE / WWVB_MARKER for seconds 0 - 59
+*/
+static uint8_t bcd(const uint8_t *symbols, const uint8_t bit, const uint8_t count)
+{
+	uint8_t value = 0;
+	for (uint8_t i = 0; i < count; ++i)
+	{
+		value = (value << 1) | (symbols[bit + i] == WWVB_ONE);
+	}
+	return value;
+}
+
+// Returns the number of format errors, t is the decoded time
+static uint16_t ref_decode(const uint8_t *symbols, date_time &t, bool &dst)
+{
+	static const uint8_t unused[] = { 4, 10, 11, 14, 20, 21, 24, 34, 35, 44, 54 };
+	uint16_t errors = 0;
+
+	for (uint8_t ss = 0; ss < 60; ++ss)
+	{
+		const bool marker = (ss == 0) | ((ss % 10) == 9);
+		if ((symbols[ss] == WWVB_MARKER) != marker)
+		{
+			++errors;
+		}
+	}
+	for (uint8_t i = 0; i < sizeof(unused); ++i)
+	{
+		if (symbols[unused[i]] != WWVB_ZERO)
+		{
+			++errors;
+		}
+	}
+
+	t.mm = bcd(symbols, 1, 3) * 10 + bcd(symbols, 5, 4);
+	t.hh = bcd(symbols, 12, 2) * 10 + bcd(symbols, 15, 4);
+	const uint16_t doy = bcd(symbols, 22, 2) * 100 + bcd(symbols, 25, 4) * 10 + bcd(symbols, 30, 4);
+	t.YY = bcd(symbols, 45, 4) * 10 + bcd(symbols, 50, 4);
+	const bool leap_year = symbols[55] == WWVB_ONE;
+	dst = (symbols[57] == WWVB_ONE) & (symbols[58] == WWVB_ONE);
+
+	// DUT1 = +0.0s : sign 101, magnitude 0
+	errors += (bcd(symbols, 36, 3) != 5) + (bcd(symbols, 40, 4) != 0);
+	// no leap second warning
+	errors += (symbols[56] != WWVB_ZERO);
+	// both DST bits change together at 0000 UTC on the change day, which is never sent here
+	errors += (symbols[57] != symbols[58]);
+	errors += (leap_year != ref_leap_year(t.YY));
+
+	if ((t.mm > 59) | (t.hh > 23) | (doy < 1) | (doy > (leap_year ? 366 : 365)) | (t.YY > 99))
+	{
+		return errors + 1;
+	}
+
+	// day of year -> DD/MM
+	uint16_t d = doy;
+	t.MM = 1;
+	while (d > ref_days_in_month(t.MM, t.YY))
+	{
+		d -= ref_days_in_month(t.MM, t.YY);
+		++t.MM;
+	}
+	t.DD = d;
+	return errors;
+}
+
+static uint16_t check_encoder()
+{
+	// every minute 2001-01-01 00:00 to 2098-12-31 23:59 would be 51M frames, so step a prime number of minutes
+	const int32_t first = ref_minutes({ 0, 0, 1, 1, 1 });
+	const int32_t last = ref_minutes({ 23, 59, 31, 12, 98 });
+	uint32_t frames = 0;
+	uint16_t failed = 0;
+	for (int32_t m = first; m <= last; m += 97)
+	{
+		const date_time t = ref_from_minutes(m);
+		const bool dst = (m / 1440) & 1;
+		uint8_t frame[8];
+		wwvb_encode_frame(frame, t.hh, t.mm, t.DD, t.MM, t.YY, dst ? TIMECODE_DST_ALL : 0);
+
+		uint8_t symbols[60];
+		for (uint8_t ss = 0; ss < 60; ++ss)
+		{
+			symbols[ss] = wwvb_symbol(frame, ss);
+		}
+		date_time decoded;
+		bool decoded_dst;
+		const uint16_t errors = ref_decode(symbols, decoded, decoded_dst);
+		if (errors | !same_time(t, decoded) | (dst != decoded_dst))
+		{
+			if (failed < 10)
+			{
+				printf("  encode %02u:%02u %02u/%02u/%02u : %u format errors, decoded %02u:%02u %02u/%02u/%02u\n",
+					t.hh, t.mm, t.DD, t.MM, t.YY, errors, decoded.hh, decoded.mm, decoded.DD, decoded.MM, decoded.YY);
+			}
+			++failed;
+		}
+		++frames;
+	}
+	printf("Encoder      : %lu frames, %u failed\n", static_cast<unsigned long>(frames), failed);
+	return failed;
+}
+
+// DST rules on the change days, hh is the standard time of the change
+static uint16_t check_dst()
+{
+	struct change
+	{
+		uint8_t rule, hh, DD, MM, YY;
+	};
+	static const change changes[] = {
+		{ TIMECODE_DST_US, 2, 10, 3, 24 }, { TIMECODE_DST_US, 1, 3, 11, 24 },
+		{ TIMECODE_DST_US, 2, 9, 3, 25 }, { TIMECODE_DST_US, 1, 2, 11, 25 },
+		{ TIMECODE_DST_EU, 2, 31, 3, 24 }, { TIMECODE_DST_EU, 2, 27, 10, 24 },
+		{ TIMECODE_DST_EU, 2, 30, 3, 25 }, { TIMECODE_DST_EU, 2, 26, 10, 25 },
+		{ TIMECODE_DST_AU, 2, 7, 4, 24 }, { TIMECODE_DST_AU, 2, 6, 10, 24 },
+		{ TIMECODE_DST_AU, 2, 6, 4, 25 }, { TIMECODE_DST_AU, 2, 5, 10, 25 } };
+	const uint8_t count = sizeof(changes) / sizeof(changes[0]);
+	uint16_t failed = 0;
+	for (uint8_t i = 0; i < count; ++i)
+	{
+		const change &c = changes[i];
+		const uint8_t before = timecode_dst_flags(c.rule, c.hh - 1, 59, c.DD, c.MM, c.YY);
+		const uint8_t after = timecode_dst_flags(c.rule, c.hh, 0, c.DD, c.MM, c.YY);
+		const bool starts = after & TIMECODE_DST;
+		uint16_t errors = (((before & TIMECODE_DST) != 0) == starts) + (((before & TIMECODE_DST_NEXT) != 0) != starts);
+		errors += !(before & TIMECODE_DST_SOON) + ((after & TIMECODE_DST_SOON) != 0);
+		errors += (((after & TIMECODE_DST_DAY_START) != 0) == starts) + (((after & TIMECODE_DST_DAY_END) != 0) != starts);
+
+		// WWVB 57:58 = 10 starts today, 01 ends today
+		uint8_t frame[8];
+		wwvb_encode_frame(frame, c.hh, 0, c.DD, c.MM, c.YY, after);
+		errors += ((wwvb_symbol(frame, 57) == WWVB_ONE) != starts) + ((wwvb_symbol(frame, 58) == WWVB_ONE) == starts);
+
+		// no change the day before
+		uint8_t D = c.DD, M = c.MM, Y = c.YY, hh = 12, mm = 0, ss = 0;
+		date_add<uint8_t>(hh, mm, ss, D, M, Y, -24, 0, 0);
+		const uint8_t day_before = timecode_dst_flags(c.rule, hh, mm, D, M, Y);
+		errors += (day_before != (starts ? 0 : TIMECODE_DST_ALL));
+		if (errors)
+		{
+			if (failed < 10)
+			{
+				printf("  dst rule %u %02u/%02u/%02u : flags %02X -> %02X, day before %02X\n",
+					c.rule, c.DD, c.MM, c.YY, before, after, day_before);
+			}
+			++failed;
+		}
+	}
+	printf("DST rules    : %u changes, %u failed\n", count, failed);
+	return failed;
+}
+
+// TimeDateTools addTimezone<>() and date_table.h date_add() have the same signature
+typedef void (*add_timezone_t)(uint8_t &, uint8_t &, uint8_t &, uint8_t &, uint8_t &, uint8_t &,
+	const int8_t, const int8_t, const int32_t);
+
+static void time_date_tools_add(uint8_t &hh, uint8_t &mm, uint8_t &ss, uint8_t &DD, uint8_t &MM, uint8_t &YY,
+	const int8_t tz_hh, const int8_t tz_mm, const int32_t seconds)
+{
+	addTimezone<uint8_t>(hh, mm, ss, DD, MM, YY, tz_hh, tz_mm, seconds);
+}
+
+static uint16_t check_timezone(const char *name, add_timezone_t add)
+{
+	const int32_t first = ref_minutes({ 0, 0, 2, 1, 1 });
+	const int32_t span = ref_minutes({ 23, 59, 30, 12, 98 }) - first;
+	const uint32_t count = 1000000;
+	uint16_t failed = 0;
+	rng_state = 12345;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const date_time t = ref_from_minutes(first + rng() % span);
+		const int8_t tz_hh = static_cast<int8_t>(rng() % 27) - 12;
+		const int8_t tz_mm = (tz_hh < 0) ? -static_cast<int8_t>(15 * (rng() % 4)) : 15 * (rng() % 4);
+		const uint8_t ss0 = rng() % 60;
+		const int32_t seconds = (i & 1) ? 1 : 0; // the one second increment used by the displays
+		const int32_t total = ss0 + seconds;
+		const date_time expected = ref_from_minutes(ref_minutes(t) + tz_hh * 60 + tz_mm + total / 60);
+
+		uint8_t hh = t.hh, mm = t.mm, ss = ss0, DD = t.DD, MM = t.MM, YY = t.YY;
+		add(hh, mm, ss, DD, MM, YY, tz_hh, tz_mm, seconds);
+		const date_time result = { hh, mm, DD, MM, YY };
+		if (!same_time(result, expected) | (ss != total % 60))
+		{
+			if (failed < 10)
+			{
+				printf("  %s %02u:%02u:%02u %02u/%02u/%02u %+d:%02d +%ds = %02u:%02u:%02u %02u/%02u/%02u, expected %02u:%02u %02u/%02u/%02u\n",
+					name, t.hh, t.mm, ss0, t.DD, t.MM, t.YY, tz_hh, abs(tz_mm), static_cast<int>(seconds),
+					hh, mm, ss, DD, MM, YY, expected.hh, expected.mm, expected.DD, expected.MM, expected.YY);
+			}
+			++failed;
+		}
+	}
+	printf("%-13s: %lu conversions, %u failed\n", name, static_cast<unsigned long>(count), failed);
+	return failed;
+}
+
+// date_to_seconds() / date_from_seconds() round trip over every day
+static uint16_t check_epoch()
+{
+	uint16_t failed = 0;
+	for (int32_t day = 0; day < 36525; ++day)
+	{
+		const date_time t = ref_from_minutes(day * 1440L + (day % 1440));
+		const uint8_t ss = day % 60;
+		const uint32_t seconds = date_to_seconds(t.hh, t.mm, ss, t.DD, t.MM, t.YY);
+		uint8_t hh, mm, s, DD, MM, YY;
+		date_from_seconds(seconds, hh, mm, s, DD, MM, YY);
+		const date_time result = { hh, mm, DD, MM, YY };
+		if ((seconds != static_cast<uint32_t>(ref_minutes(t)) * 60 + ss) | !same_time(t, result) | (s != ss))
+		{
+			if (failed < 10)
+			{
+				printf("  epoch %02u:%02u:%02u %02u/%02u/%02u = %lu -> %02u:%02u:%02u %02u/%02u/%02u\n",
+					t.hh, t.mm, ss, t.DD, t.MM, t.YY, static_cast<unsigned long>(seconds), hh, mm, s, DD, MM, YY);
+			}
+			++failed;
+		}
+	}
+	printf("date_table   : 36525 days, %u failed\n", failed);
+	return failed;
+}
+
+struct timing
+{
+	double sum, sum_sq, max_abs;
+	uint32_t n;
+
+	void add(const double error)
+	{
+		sum += error;
+		sum_sq += error * error;
+		max_abs = (fabs(error) > max_abs) ? fabs(error) : max_abs;
+		++n;
+	}
+
+	void print(const char *name, const double scale, const char *unit)
+	{
+		if (n == 0)
+		{
+			return;
+		}
+		const double mean = sum / n;
+		const double rms = sqrt(sum_sq / n);
+		printf("%-13s: mean %+10.3f %s, rms %9.3f %s, max %9.3f %s (%lu)\n", name,
+			mean * scale, unit, rms * scale, unit, max_abs * scale, unit, static_cast<unsigned long>(n));
+	}
+};
+
+static wwvb_frame wwvb_tx;
+
+// Timer2 CTC backend : the carrier is on while OC2A toggles, two interrupts per carrier cycle
+static timecode_tx<TIMECODE_WWVB, wwvb_timer2> wwvb_tx2;
+
+// WWVB_DITHER : the 16MHz carriers of the table in wwvb_frame.h are all on frequency
+static_assert((wwvb_frame::CARRIER_ERROR_HZ == 0) & wwvb_frame::CARRIER_RX, "Timer1 WWVB carrier");
+static_assert((timecode_tx<TIMECODE_WWVB, wwvb_timer2>::CARRIER_ERROR_HZ == 0) & timecode_tx<TIMECODE_WWVB, wwvb_timer2>::CARRIER_RX, "Timer2 WWVB carrier");
+static_assert((timecode_tx<TIMECODE_DCF77>::CARRIER_ERROR_HZ == 0) & timecode_tx<TIMECODE_DCF77>::CARRIER_RX, "Timer1 DCF77 carrier");
+static_assert(timecode_timer<60000UL, 0>::TICKS_PER_SECOND == 60000UL, "Timer1 WWVB cycles per second");
+
+// Average timer clocks per carrier cycle (ICR1 / OCR2A + 1 move by a clock every few cycles),
+// the simulated overflows are evenly spaced at this, i.e. within a clock of the dithered ones
+static const double wwvb_period = timecode_timer<60000UL, 0>::PERIOD + timecode_timer<60000UL, 0>::TOP_FRAC / 65536.0;
+static const double wwvb2_period = timecode_timer<120000UL, 0>::PERIOD + timecode_timer<120000UL, 0>::TOP_FRAC / 65536.0;
+
+static uint16_t check_timer2()
+{
+	const date_time start = { 12, 0, 1, 6, 24 };
+	host_millis = 0;
+	host_micros = 0;
+	wwvb_tx2.setup();
+	wwvb_tx2.calibrate_q16(0);
+	wwvb_tx2.setPWM_LOW(WWVB_PWM_LOW_TRUE); // no pulse width, stays carrier off
+	wwvb_tx2.set_time(start.hh, start.mm, start.DD, start.MM, start.YY);
+	wwvb_tx2.start();
+
+	// the compare matches are at the clocks of the (dithered) half cycles
+	const double step = wwvb2_period / static_cast<double>(F_CPU);
+	uint64_t clocks = 0;
+	uint16_t period = OCR2A + 1;
+	const uint64_t total = static_cast<uint64_t>(180.0 / step);
+	uint64_t t_low = 0, t_second = 0;
+	bool have_second = false, low = true;
+	uint8_t symbols[60];
+	uint8_t ss = 0;
+	uint16_t frames = 0, failed = 0, wrong_low = 0;
+	timing second = {};
+	for (uint64_t i = 1; i <= total; ++i)
+	{
+		clocks += period;
+		host_millis = clocks * 1000.0 / F_CPU;
+		host_micros = clocks * 1e6 / F_CPU;
+		wwvb_tx2.interrupt_routine();
+		period = OCR2A + 1;
+		const bool now_low = !(TCCR2A & _BV(COM2A0));
+		if (now_low == low)
+		{
+			continue;
+		}
+		low = now_low;
+		if (!low)
+		{
+			const double length = static_cast<double>(clocks - t_low) / F_CPU;
+			symbols[ss] = (length < 0.35) ? WWVB_ZERO : ((length < 0.65) ? WWVB_ONE : WWVB_MARKER);
+			wwvb_tx2.update();
+			if (++ss == 60)
+			{
+				ss = 0;
+				date_time t;
+				bool dst;
+				failed += (ref_decode(symbols, t, dst) != 0) | !same_time(t, ref_from_minutes(ref_minutes(start) + frames));
+				++frames;
+			}
+			continue;
+		}
+		if (have_second)
+		{
+			second.add(static_cast<double>(clocks - t_second) / F_CPU - 1.0);
+		}
+		t_second = clocks;
+		t_low = clocks;
+		have_second = true;
+		wrong_low += (TCCR2A != _BV(WGM21)); // OC2A disconnected
+	}
+	wwvb_tx2.stop();
+
+	const double carrier_hz = total * (F_CPU / 2.0) / clocks;
+	const bool ok = (frames >= 2) & (failed == 0) & (wrong_low == 0) & (fabs(second.sum / second.n) < 1e-6) & (fabs(carrier_hz - 60000.0) < TIMECODE_CARRIER_HZ_RX);
+	printf("Timer2       : %u frames, %u failed, %.1f Hz carrier, second %+.3f us mean, %.3f us max\n",
+		frames, failed, carrier_hz, second.sum / second.n * 1e6, second.max_abs * 1e6);
+	return !ok;
+}
+
+static uint16_t check_transmitter(const uint32_t minutes, const double cpu_ppm, const double trim)
+{
+	const date_time start = { 23, 0, 31, 12, 23 }; // crosses the new year into a leap year
+	const double f_cpu = F_CPU * (1.0 + cpu_ppm * 1e-6);
+
+	host_millis = 0;
+	host_micros = 0;
+	wwvb_tx.setup();
+	wwvb_tx.calibrate_q16(lround(trim * 65536.0));
+	wwvb_tx.setPWM_LOW(0);
+	wwvb_tx.set_time(start.hh, start.mm, start.DD, start.MM, start.YY);
+	wwvb_tx.start();
+
+	// the new compare value is latched by the next PWM period, one overflow behind
+	// The overflows are at the clocks of the (dithered) cycles, the TOP each interrupt leaves
+	const double cycle = wwvb_period / f_cpu;
+	uint64_t overflow = 0;
+	uint64_t clocks = 0;
+	uint16_t period = ICR1 + 1;
+	uint64_t t_low = 0, t_second = 0, t_frame = 0;
+	bool have_second = false, have_frame = false;
+	bool low = true;
+	uint8_t symbols[60];
+	uint8_t ss = 0;
+	uint32_t frames = 0;
+	uint16_t failed = 0;
+	uint16_t clock_failed = 0;
+	timing second = {}, frame = {}, symbol[3] = {};
+	static const double nominal_low[3] = { 0.2, 0.5, 0.8 };
+
+	const uint64_t total = static_cast<uint64_t>(minutes * 60.0 / cycle);
+	const auto t0 = std::chrono::steady_clock::now();
+	for (overflow = 1; overflow <= total; ++overflow)
+	{
+		clocks += period;
+		host_millis = clocks / f_cpu * 1000.0;
+		host_micros = clocks / f_cpu * 1e6;
+		wwvb_tx.interrupt_routine();
+		period = ICR1 + 1;
+
+		const bool now_low = WWVB_OCR == 0;
+		if (now_low == low)
+		{
+			continue;
+		}
+		low = now_low;
+
+		if (!low)
+		{
+			// end of the reduced power period : the length identifies the symbol
+			const double length = (clocks - t_low) / f_cpu;
+			const uint8_t s = (length < 0.35) ? WWVB_ZERO : ((length < 0.65) ? WWVB_ONE : WWVB_MARKER);
+			symbol[s].add(length - nominal_low[s]);
+			symbols[ss] = s;
+
+			wwvb_tx.update(); // loop() encodes the next minute and decodes the loopback trace
+
+			if (++ss == 60)
+			{
+				ss = 0;
+				date_time t;
+				bool dst;
+				const date_time expected = ref_from_minutes(ref_minutes(start) + frames);
+				const uint16_t errors = ref_decode(symbols, t, dst);
+				if (errors | !same_time(t, expected) | dst)
+				{
+					if (failed < 10)
+					{
+						printf("  frame %lu : %u format errors, decoded %02u:%02u %02u/%02u/%02u expected %02u:%02u %02u/%02u/%02u\n",
+							static_cast<unsigned long>(frames), errors, t.hh, t.mm, t.DD, t.MM, t.YY,
+							expected.hh, expected.mm, expected.DD, expected.MM, expected.YY);
+					}
+					++failed;
+				}
+				++frames;
+			}
+			continue;
+		}
+
+		// start of a second
+		if (have_second)
+		{
+			second.add((clocks - t_second) / f_cpu - 1.0);
+		}
+		if (ss == 0)
+		{
+			// the clock is ticked at the start of every second, so it is exactly on the minute
+			const date_time expected = ref_from_minutes(ref_minutes(start) + frames);
+			if (wwvb_tx.clock.now() != date_to_seconds(expected.hh, expected.mm, 0, expected.DD, expected.MM, expected.YY))
+			{
+				++clock_failed;
+			}
+			if (have_frame)
+			{
+				frame.add((clocks - t_frame) / f_cpu - 60.0);
+			}
+			t_frame = clocks;
+			have_frame = true;
+		}
+		t_second = clocks;
+		t_low = clocks;
+		have_second = true;
+	}
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	wwvb_tx.update();
+	wwvb_loopback_stats loopback;
+	wwvb_tx.get_loopback(loopback);
+
+	printf("Transmitter  : %lu frames, %u failed (cpu %+.1f ppm, trim %+.4f, %.4f carrier cycles/s)\n",
+		static_cast<unsigned long>(frames), failed, cpu_ppm, trim, total * static_cast<double>(F_CPU) / clocks + trim);
+	printf("  clock      : %u minutes wrong\n", clock_failed);
+	printf("  loopback   : %lu seconds, %lu bad\n", static_cast<unsigned long>(loopback.seconds), static_cast<unsigned long>(loopback.bad_seconds));
+	second.print("  second", 1e6, "us");
+	frame.print("  frame", 1e3, "ms");
+	symbol[WWVB_ZERO].print("  0 (0.2s)", 1e6, "us");
+	symbol[WWVB_ONE].print("  1 (0.5s)", 1e6, "us");
+	symbol[WWVB_MARKER].print("  M (0.8s)", 1e6, "us");
+	if (second.n)
+	{
+		printf("  rate error : %+.3f ppm\n", second.sum / second.n * 1e6);
+	}
+	printf("interrupt    : %8.2f ns/iteration (simulation loop)\n", elapsed * 1e9 / total);
+	return failed + clock_failed + (frames == 0) + (loopback.bad_seconds != 0);
+}
+
+// Three minutes with the overflow interrupt held off for 30ms (lost carrier cycles) in the second one
+static uint16_t check_loopback()
+{
+	host_millis = 0;
+	host_micros = 0;
+	wwvb_tx.setup();
+	wwvb_tx.calibrate_q16(0);
+	wwvb_tx.setPWM_LOW(0);
+	wwvb_tx.set_time(12, 0, 1, 6, 24);
+	wwvb_tx.start();
+
+	const double cycle = wwvb_period / static_cast<double>(F_CPU);
+	const uint64_t total = static_cast<uint64_t>(180.0 / cycle);
+	const uint64_t blocked = static_cast<uint64_t>(90.5 / cycle);
+	const uint64_t blocked_end = blocked + static_cast<uint64_t>(0.030 / cycle);
+	for (uint64_t overflow = 1; overflow <= total; ++overflow)
+	{
+		host_millis = overflow * cycle * 1000.0;
+		host_micros = overflow * cycle * 1e6;
+		if ((overflow >= blocked) & (overflow < blocked_end))
+		{
+			continue;
+		}
+		wwvb_tx.interrupt_routine();
+		if ((overflow % 1000) == 0)
+		{
+			wwvb_tx.update();
+		}
+	}
+	wwvb_tx.update();
+
+	wwvb_loopback_stats stats;
+	wwvb_tx.get_loopback(stats);
+	const bool ok = (stats.bad_seconds == 1) & (stats.bad_minutes == 1) & (stats.seconds >= 178);
+	printf("Loopback     : %lu seconds, %lu bad in %u minutes, worst %u ms (30ms held off)\n",
+		static_cast<unsigned long>(stats.seconds), static_cast<unsigned long>(stats.bad_seconds), stats.bad_minutes, stats.worst_ms);
+	return !ok;
+}
+
+// 9 minutes on, 1 off resync cycles against a GPS, the 0s sentence burst 120ms after the (true) second
+// OC1B against OC1A for every carrier cycle of 3 seconds (a marker, a one and a zero)
+static uint32_t dual_errors(const uint8_t phase, const uint8_t percent)
+{
+	wwvb_tx.setup();
+	wwvb_tx.calibrate_q16(0);
+	wwvb_tx.setPWM_LOW(0);
+	wwvb_tx.set_output_b(phase, percent);
+	const uint16_t period = ICR1 + 1;
+	const uint16_t high = period >> 1;
+	const uint16_t low = timecode_duty_low(period, percent, timecode_encoder<TIMECODE_WWVB>::LOW_Q16);
+	const uint16_t off = period + (WWVB_DITHER == 1); // inverted carrier off : past the longer TOP of the dithered cycles
+	const bool invert = (phase == WWVB_PHASE_180);
+	uint32_t errors = !invert ? (OCR1B != 0) + ((TCCR1A & _BV(COM1B0)) != 0) : (OCR1B != off) + ((TCCR1A & _BV(COM1B0)) == 0);
+
+	wwvb_tx.set_time(12, 0, 1, 6, 24);
+	wwvb_tx.start();
+	const uint32_t cycles = static_cast<uint32_t>(3.0 * F_CPU / period);
+	for (uint32_t i = 0; i < cycles; ++i)
+	{
+		wwvb_tx.interrupt_routine();
+		const uint16_t b = (OCR1A == high) ? high : low;
+		errors += (OCR1B != (invert ? period - b : b));
+	}
+	wwvb_tx.stop();
+	errors += (OCR1B != (invert ? off : 0));
+	return errors;
+}
+
+static uint16_t check_dual()
+{
+	const uint32_t in_phase = dual_errors(WWVB_PHASE_0, 0);
+	const uint32_t h_bridge = dual_errors(WWVB_PHASE_180, WWVB_PWM_LOW_TRUE);
+	wwvb_tx.set_output_b(WWVB_PHASE_0, WWVB_PWM_LOW);
+	printf("Dual output  : %lu in phase, %lu inverted at -17dB errors\n",
+		static_cast<unsigned long>(in_phase), static_cast<unsigned long>(h_bridge));
+	return (in_phase + h_bridge) != 0;
+}
+
+// The WWVB leap second warning (second 56) of the first minute sent for hh:mm DD/MM/YY + tz_hh
+static uint8_t leap_symbol(const int8_t tz_hh, const uint8_t hh, const uint8_t mm, const uint8_t DD, const uint8_t MM, const uint8_t YY)
+{
+	host_millis = 0;
+	host_micros = 0;
+	wwvb_tx.setup();
+	wwvb_tx.calibrate_q16(0);
+	wwvb_tx.setTimezone(tz_hh, 0);
+	wwvb_tx.set_leap_second(12, 23);
+	wwvb_tx.set_time(hh, mm, DD, MM, YY);
+	wwvb_tx.start();
+	uint64_t clocks = 0, t_low = 0;
+	uint16_t period = ICR1 + 1;
+	uint8_t ss = 0, s = WWVB_MARKER;
+	bool low = true;
+	while (ss <= 56)
+	{
+		clocks += period;
+		host_millis = clocks * 1000.0 / F_CPU;
+		host_micros = clocks * 1e6 / F_CPU;
+		wwvb_tx.interrupt_routine();
+		period = ICR1 + 1;
+		const bool now_low = WWVB_OCR == 0;
+		if (now_low == low)
+		{
+			continue;
+		}
+		low = now_low;
+		if (low)
+		{
+			t_low = clocks;
+			continue;
+		}
+		const double length = static_cast<double>(clocks - t_low) / F_CPU;
+		s = (length < 0.35) ? WWVB_ZERO : ((length < 0.65) ? WWVB_ONE : WWVB_MARKER);
+		wwvb_tx.update();
+		++ss;
+	}
+	wwvb_tx.stop();
+	wwvb_tx.setTimezone(0, 0);
+	wwvb_tx.set_leap_second(0, 0);
+	return s;
+}
+
+// set_leap_second() is the month of the given time, the timezone can move the frame into the month next to it
+static uint16_t check_leap()
+{
+	const bool dec_into_jan = leap_symbol(1, 23, 30, 31, 12, 23) == WWVB_ONE; // sent as 00:30 1/1/24
+	const bool jan_into_dec = leap_symbol(-1, 0, 30, 1, 1, 24) == WWVB_ZERO; // sent as 23:30 31/12/23
+	const bool dec = leap_symbol(0, 12, 0, 15, 12, 23) == WWVB_ONE;
+	printf("Leap second  : warning %s in the leap month, %s after it across a timezone, %s into the month before\n",
+		dec ? "set" : "MISSING", dec_into_jan ? "set" : "MISSING", jan_into_dec ? "clear" : "SET");
+	return !(dec_into_jan & jan_into_dec & dec);
+}
+
+static uint16_t check_drift()
+{
+	const double cpu_ppm = 300.0;
+	host_millis = 0;
+	host_micros = 0;
+	wwvb_tx.setup();
+	wwvb_tx.calibrate_q16(0);
+	wwvb_tx.reset_drift();
+	wwvb_tx.set_drift_auto(true);
+
+	const double cycle_cpu = wwvb_period / static_cast<double>(F_CPU); // micros() counts the resonator
+	const double cycle = cycle_cpu / (1.0 + cpu_ppm * 1e-6);
+	const uint32_t t0 = date_to_seconds(12, 0, 0, 1, 6, 24);
+	uint64_t overflow = 0;
+	for (uint8_t k = 0; k < 12; ++k)
+	{
+		for (uint8_t on = 0; on < 2; ++on)
+		{
+			// the resync at minute 10k, or the stop at minute 10k + 9
+			const double t_end = k * 600.0 + (on ? 540.1 : 0.120);
+			while ((overflow + 1) * cycle < t_end)
+			{
+				++overflow;
+				host_millis = overflow * cycle_cpu * 1000.0;
+				host_micros = overflow * cycle_cpu * 1e6;
+				if (wwvb_tx.is_active())
+				{
+					wwvb_tx.interrupt_routine();
+				}
+			}
+			if (on)
+			{
+				wwvb_tx.stop();
+				continue;
+			}
+			const uint32_t t = t0 + k * 600UL;
+			uint8_t hh, mm, ss, DD, MM, YY;
+			date_from_seconds(t, hh, mm, ss, DD, MM, YY);
+			wwvb_tx.drift(t, host_micros);
+			wwvb_tx.set_time(hh, mm, DD, MM, YY);
+			wwvb_tx.start();
+		}
+	}
+
+	wwvb_drift_stats stats;
+	wwvb_tx.get_drift(stats);
+	const double expected = F_CPU / wwvb_period * cpu_ppm * 1e-6;
+	const double residual_ppm = (wwvb_tx.trim_q16() / 65536.0 - expected) / (F_CPU / wwvb_period) * 1e6;
+	const bool ok = (stats.count == 11) & (stats.corrections > 0) & wwvb_tx.drift_settled() & (fabs(residual_ppm) <= WWVB_DRIFT_DEADBAND_PPB * 1e-3);
+	printf("Drift        : %u rates, %u corrections, last %+ld ppb, trim %+.3f (residual %+.2f ppm, cpu %+.0f ppm)\n",
+		stats.count, stats.corrections, static_cast<long>(stats.rate_ppb), wwvb_tx.trim_q16() / 65536.0, residual_ppm, cpu_ppm);
+	return !ok;
+}
+
+// PPS edges lag carrier cycles before the transmitter second (-ve : after, it starts early),
+// with the resonator cpu_ppm fast. Returns the worst start of a second against its edge over
+// the last 10 of 40 seconds (+1 or 2 : where the edge falls between two overflows)
+static int32_t pps_offset(const int32_t lag, const double cpu_ppm, uint32_t &edges)
+{
+	host_millis = 0;
+	host_micros = 0;
+	wwvb_tx.setup();
+	wwvb_tx.calibrate_q16(0);
+	wwvb_tx.set_time(12, 0, 1, 6, 24);
+	wwvb_tx.start();
+
+	const double cps = F_CPU / wwvb_period * (1.0 + cpu_ppm * 1e-6); // overflows per GPS second
+	uint32_t k = (lag < 0) ? 0 : 1;
+	int32_t worst = 0;
+	edges = 0;
+	uint8_t ss = wwvb_tx.ss();
+	for (uint32_t overflow = 1; overflow < 40 * cps; ++overflow)
+	{
+		wwvb_tx.interrupt_routine();
+		if (wwvb_tx.ss() != ss)
+		{
+			// a second starts with this overflow
+			ss = wwvb_tx.ss();
+			const int32_t offset = static_cast<int32_t>(overflow + lag - floor((overflow + lag) / cps + 0.5) * cps);
+			if ((overflow > 30 * cps) & (abs(offset) > abs(worst)))
+			{
+				worst = offset;
+			}
+		}
+		if (overflow >= k * cps - lag)
+		{
+			wwvb_tx.pps_interrupt();
+			++edges;
+			++k;
+		}
+	}
+	wwvb_tx.stop();
+	return worst;
+}
+
+// Phase and rate lock onto the PPS, from a few cycles to more than the 50ms a second the phase can move
+static uint16_t check_pps()
+{
+	static const int16_t lags[] = { 3, 100, -100, 2000, 5000, 100 };
+	static const double ppm[] = { 0, 0, 0, 0, 0, 20 };
+	uint16_t failed = 0;
+	printf("PPS          : lag / worst start of second / trim");
+	for (uint8_t i = 0; i < sizeof(lags) / sizeof(lags[0]); ++i)
+	{
+		uint32_t edges;
+		const int32_t worst = pps_offset(lags[i], ppm[i], edges);
+		const double trim = wwvb_tx.trim_q16() / 65536.0;
+		const double expected = F_CPU / wwvb_period * ppm[i] * 1e-6;
+		const bool ok = (abs(worst) <= 2) & (fabs(trim - expected) < 0.5) & (edges >= 39);
+		printf("%s %+d/%+ld/%+.2f%s", i ? "," : "", lags[i], static_cast<long>(worst), trim, ok ? "" : " FAILED");
+		failed += !ok;
+	}
+	printf(" (last +20ppm)\n");
+	wwvb_tx.calibrate_q16(0);
+	return failed != 0;
+}
+
+// a Print that keeps what was written
+struct status_capture : Print
+{
+	uint8_t b[128];
+	size_t n;
+	virtual size_t write(const uint8_t c) { b[n++ & 0x7F] = c; return 1; }
+};
+
+static uint32_t le32(const uint8_t *b) { return b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<uint32_t>(b[3]) << 24); }
+static uint16_t le16(const uint8_t *b) { return b[0] | (b[1] << 8); }
+
+// after check_drift() : the drift section has counts in it
+static uint16_t check_status()
+{
+	uint16_t errors = 0;
+	wwvb_status<wwvb_frame> status(wwvb_tx);
+	status.synced();
+	status.synced();
+
+	// boot, then 49.7 days later across the millis() rollover
+	host_millis = 4294967000UL;
+	errors += (status.uptime() != 4294967);
+	host_millis = 5000;
+
+	status_capture out;
+	out.n = 0;
+	status.send(out, 1, 9, WWVB_STATUS_VALID);
+
+	const uint8_t *f = out.b;
+	const uint8_t length = WWVB_STATUS_BASE + WWVB_STATUS_DRIFT_SIZE + WWVB_STATUS_LOOPBACK_SIZE;
+	uint8_t ck_a = 0, ck_b = 0;
+	for (uint8_t i = 2; i < 4 + length; ++i)
+	{
+		ck_a += f[i];
+		ck_b += ck_a;
+	}
+	errors += (out.n != 6U + length) | (f[0] != 0xB5) | (f[1] != 0x57) | (f[2] != WWVB_STATUS_VERSION) | (f[3] != length);
+	errors += (f[4 + length] != ck_a) | (f[5 + length] != ck_b);
+
+	const uint8_t *p = &f[4];
+	const uint8_t flags = WWVB_STATUS_VALID | (wwvb_tx.is_active() ? WWVB_STATUS_ACTIVE : 0) | (wwvb_tx.drift_settled() ? WWVB_STATUS_SETTLED : 0);
+	errors += (p[0] != (WWVB_STATUS_DRIFT | WWVB_STATUS_LOOPBACK)) | (p[1] != flags) | (p[2] != 1) | (p[3] != 9);
+	errors += (le32(&p[4]) != 4294972) | (le32(&p[8]) != wwvb_tx.clock.now()) | (le16(&p[12]) != 2);
+	errors += (static_cast<int32_t>(le32(&p[14])) != wwvb_tx.trim_q16());
+
+	wwvb_drift_stats dr;
+	wwvb_tx.get_drift(dr);
+	p += WWVB_STATUS_BASE;
+	errors += (static_cast<int32_t>(le32(&p[0])) != dr.offset_us) | (static_cast<int32_t>(le32(&p[4])) != dr.rate_ppb);
+	errors += (static_cast<int32_t>(le32(&p[8])) != dr.worst_ppb) | (le16(&p[12]) != dr.count) | (le16(&p[14]) != dr.corrections) | (le16(&p[16]) != dr.span);
+	errors += (dr.count == 0);
+
+	wwvb_loopback_stats lb;
+	wwvb_tx.get_loopback(lb);
+	p += WWVB_STATUS_DRIFT_SIZE;
+	errors += (le32(&p[0]) != lb.seconds) | (le32(&p[4]) != lb.bad_seconds) | (le16(&p[8]) != lb.bad_minutes);
+	errors += (p[10] != lb.last_minute) | (p[11] != lb.worst_minute) | (le16(&p[12]) != lb.worst_ms);
+
+	printf("Status frame : %u bytes, %u errors\n", static_cast<unsigned>(out.n), errors);
+	return errors;
+}
+
+static epoch_clock task_clock;
+static uint32_t task_slice, task_fast_runs, task_second_runs, task_slow_runs, task_late;
+static uint32_t task_periodic_slice = 0xFFFFFFFF;
+static bool task_shared;
+
+static void task_periodic()
+{
+	task_shared |= (task_periodic_slice == task_slice);
+	task_periodic_slice = task_slice;
+}
+
+static void task_fast() { ++task_fast_runs; }
+
+static void task_second()
+{
+	task_periodic();
+	++task_second_runs;
+	task_late += (task_clock.ms() >= 100);
+}
+
+static void task_slow()
+{
+	task_periodic();
+	++task_slow_runs;
+	host_micros += 3000; // over its 2ms budget
+}
+
+static uint16_t check_tasks()
+{
+	const wwvb_task table[] = {
+		{ task_fast, 0, 0, 1 },
+		{ task_second, WWVB_TASK_SLOTS, 0, 1 },
+		{ task_slow, 1, 0, 2 }
+		};
+	host_millis = 0;
+	host_micros = 0;
+	task_clock.set(12, 0, 0, 1, 6, 24);
+	wwvb_tasks tasks(table, 3, task_clock);
+
+	// 4 slices a millisecond for 60s, then the clock is set back an hour for 10s
+	for (task_slice = 0; task_slice < 280000; ++task_slice)
+	{
+		if (task_slice == 240000)
+		{
+			task_clock.set(11, 1, 0, 1, 6, 24);
+		}
+		host_millis = task_slice / 4;
+		host_micros = host_millis * 1000;
+		tasks.run();
+	}
+
+	// the first slice runs the second task, the slow task catches up on the next slice
+	const bool ok = (task_fast_runs == 280000) & (task_second_runs == 71) & (task_late == 0) &
+		!task_shared & (task_slow_runs == 701) & (tasks.overruns(2) == 701) & (tasks.overruns(1) == 0);
+	printf("Tasks        : %lu slices, %lu second runs (%lu late), %lu slot runs, %u overruns\n",
+		static_cast<unsigned long>(task_fast_runs), static_cast<unsigned long>(task_second_runs),
+		static_cast<unsigned long>(task_late), static_cast<unsigned long>(task_slow_runs), tasks.overruns(2));
+	return !ok;
+}
+
+// "$" body "*" checksum "\r\n" into the parser
+static void nmea_send(nmea_time &gps, const char *body)
+{
+	uint8_t checksum = 0;
+	for (const char *c = body; *c; ++c)
+	{
+		checksum ^= *c;
+	}
+	char sentence[100];
+	snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+	for (const char *c = sentence; *c; ++c)
+	{
+		gps.parse(*c);
+	}
+}
+
+static uint16_t check_nmea()
+{
+	uint16_t errors = 0;
+	nmea_time gps;
+	gps.setTimezone(10, 30);
+
+	// before the fix : empty fields, no time
+	nmea_send(gps, "GPRMC,,V,,,,,,,,,,N");
+	errors += gps.new_data();
+
+	// 23:59:59.00 UTC on 31/12/24 is 10:29:59 on 1/1/25 in ACDT
+	nmea_send(gps, "GPGGA,235959.00,3455.1234,S,13836.5678,E,1,07,1.02,45.0,M,-3.6,M,,");
+	nmea_send(gps, "GPRMC,235959.00,A,3455.1234,S,13836.5678,E,0.01,,311224,,,A");
+	errors += !gps.new_data() | gps.new_data();
+	errors += (gps.hh != 10) | (gps.mm != 29) | (gps.ss != 59) | (gps.DD != 1) | (gps.MM != 1) | (gps.YY != 25);
+	errors += !gps.IsValid | (gps.quality != 1) | (gps.satellites != 7);
+
+	// GN talker, no fix but the receiver's clock time, not valid
+	nmea_send(gps, "GNRMC,120000,V,,,,,,,150626,,,N");
+	errors += !gps.new_data() | gps.IsValid | (gps.hh != 22) | (gps.mm != 30) | (gps.ss != 0) | (gps.DD != 15);
+
+	// a bit flipped in the serial reader, the checksum doesn't match
+	nmea_send(gps, "GNGGA,120001,,,,,2,12,,,,,,,");
+	nmea_send(gps, "GNRMC,120001,A,,,,,,,150626,,,N");
+	const char flipped[] = "$GNRMC,120003,A,,,,,,,150626,,,N*5D\r\n"; // the checksum of 120002
+	for (const char *c = flipped; *c; ++c)
+	{
+		gps.parse(*c);
+	}
+	errors += (gps.new_data() != true) | (gps.ss != 1) | (gps.quality != 2) | (gps.satellites != 12) | gps.new_data();
+
+	// the other sentences and a header broken off are skipped
+	nmea_send(gps, "GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30");
+	nmea_send(gps, "GPRM");
+	nmea_send(gps, "GPRMCX,120003,A,,,,,,,150626,,,N");
+	errors += gps.new_data();
+
+	printf("NMEA time    : %u errors\n", errors);
+	return errors;
+}
+
+// NTP server at the other end of a simulated network, UTC = micros() + offset_us
+struct ntp_server
+{
+	int64_t offset_us; // UTC us since 1900 at micros() 0
+	uint8_t request[NTP_TIME_PACKET];
+	uint8_t reply[NTP_TIME_PACKET];
+	bool sent, ready;
+	uint8_t stratum;
+
+	void begin(uint16_t) {}
+	void beginPacket(const char *, uint16_t) {}
+	void write(const uint8_t *b, size_t n) { memcpy(request, b, n); }
+	void endPacket() { sent = true; }
+	int parsePacket() { const bool r = ready; ready = false; return r ? NTP_TIME_PACKET : 0; }
+	int read(uint8_t *b, size_t n) { memcpy(b, reply, n); return n; }
+
+	static void put_time(uint8_t *b, const int64_t us)
+	{
+		const uint32_t s = us / 1000000, f = ((us % 1000000) << 32) / 1000000;
+		const uint32_t v[2] = { s, f };
+		for (uint8_t i = 0; i < 8; ++i)
+		{
+			b[i] = v[i >> 2] >> (24 - 8 * (i & 3));
+		}
+	}
+
+	// the request arrives after up_us, the reply leaves hold_us later and takes down_us
+	void answer(const uint32_t up_us, const uint32_t hold_us, const uint32_t down_us)
+	{
+		sent = false;
+		memset(reply, 0, sizeof(reply));
+		reply[0] = 0x24; // LI 0, version 4, mode 4 (server)
+		reply[1] = stratum;
+		memcpy(&reply[24], &request[40], 8);
+		ntp_advance(up_us);
+		put_time(&reply[32], host_micros + offset_us);
+		ntp_advance(hold_us);
+		put_time(&reply[40], host_micros + offset_us);
+		ntp_advance(down_us);
+		ready = true;
+	}
+
+	static void ntp_advance(const uint32_t us)
+	{
+		host_micros += us;
+		host_millis = host_micros / 1000;
+	}
+};
+
+static uint16_t check_ntp()
+{
+	uint16_t errors = 0;
+	ntp_server server = {};
+	ntp_time ntp;
+	ntp.setTimezone(10, 30);
+	ntp.begin(server);
+	server.stratum = 1;
+
+	// 23:59:58.3 UTC 31/12/24 at micros() 10s, the second starts at 9.7s + k
+	host_micros = 10000000;
+	host_millis = 10000;
+	server.offset_us = (static_cast<int64_t>(date_to_seconds(23, 59, 58, 31, 12, 24)) + NTP_TIME_EPOCH_2000) * 1000000 + 300000 - 10000000;
+	const uint32_t second_us = 9700000;
+
+	// the first request goes out straight away, no time before the reply
+	ntp.poll(server, "ntp");
+	errors += !server.sent | ntp.IsValid | ntp.new_data();
+
+	// the burst, 2s apart : asymmetric (37.5ms off), a kiss-o'-death (times out), symmetric, slower
+	const uint32_t path[4][2] = { { 5000, 80000 }, { 1000, 1000 }, { 2000, 2000 }, { 30000, 30000 } };
+	int32_t phase[4];
+	for (uint8_t i = 0; i < 4; ++i)
+	{
+		server.stratum = (i == 1) ? 0 : 1;
+		server.answer(path[i][0], 300, path[i][1]);
+		ntp.poll(server, "ntp");
+		phase[i] = static_cast<int32_t>(ntp.second_us() % 1000000) - static_cast<int32_t>(second_us % 1000000);
+		ntp_server::ntp_advance(NTP_TIME_GAP_MS * 1000UL - path[i][0] - path[i][1] - 300);
+		ntp.poll(server, "ntp");
+		errors += (server.sent != (i < 3)); // nothing after the burst until NTP_TIME_POLL_S
+	}
+	errors += (abs(phase[0] - 37500) > 2) | (phase[1] != phase[0]) | (abs(phase[2]) > 2) | (phase[3] != phase[2]);
+	errors += (ntp.delay_us() != 4000) | (ntp.stratum != 1);
+
+	// 23:59:58 + 10s = 00:00:08 on 01/01/25 UTC, 10:30:08 ACDT, once at the start of the second
+	ntp_server::ntp_advance(second_us + 10001000 - host_micros);
+	ntp.new_data();
+	ntp.poll(server, "ntp");
+	errors += !ntp.new_data() | !ntp.IsValid;
+	errors += (ntp.hh != 10) | (ntp.mm != 30) | (ntp.ss != 8) | (ntp.DD != 1) | (ntp.MM != 1) | (ntp.YY != 25);
+	ntp_server::ntp_advance(998000);
+	ntp.poll(server, "ntp");
+	errors += ntp.new_data() | (ntp.ss != 8) | (abs(static_cast<int32_t>(ntp.second_us() - (second_us + 10000000))) > 2);
+
+	// the next burst, a reply to an older request is not used and the request times out
+	ntp_server::ntp_advance(NTP_TIME_POLL_S * 1000000UL);
+	ntp.poll(server, "ntp");
+	ntp.poll(server, "ntp");
+	errors += !server.sent;
+	server.answer(1000, 300, 1000);
+	server.reply[27] ^= 0x01;
+	ntp.poll(server, "ntp");
+	ntp_server::ntp_advance(NTP_TIME_TIMEOUT_MS * 1000UL);
+	ntp.poll(server, "ntp");
+	errors += (ntp.delay_us() != 4000) | server.sent;
+
+	printf("NTP time     : %u errors\n", errors);
+	return errors;
+}
+
+// keeps the benchmarked results live
+static volatile uint8_t sink;
+
+static void benchmark_timezone(const char *name, add_timezone_t add, const date_time *t, const uint32_t count)
+{
+	const auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const date_time &d = t[i & 0xFF];
+		uint8_t hh = d.hh, mm = d.mm, ss = i % 60, DD = d.DD, MM = d.MM, YY = d.YY;
+		add(hh, mm, ss, DD, MM, YY, static_cast<int8_t>(i % 27) - 12, 0, i & 1);
+		sink = hh ^ DD;
+	}
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	printf("%-13s: %8.2f ns/iteration\n", name, elapsed * 1e9 / count);
+}
+
+static void benchmark()
+{
+	const uint32_t count = 2000000;
+	date_time t[256];
+	for (uint16_t i = 0; i < 256; ++i)
+	{
+		t[i] = ref_from_minutes(ref_minutes({ 0, 0, 1, 1, 1 }) + rng() % 50000000L);
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const date_time &d = t[i & 0xFF];
+		uint8_t frame[8];
+		wwvb_encode_frame(frame, d.hh, d.mm, d.DD, d.MM, d.YY, (i & 1) ? TIMECODE_DST_ALL : 0);
+		sink = frame[i & 0x07];
+	}
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	printf("encode       : %8.2f ns/iteration\n", elapsed * 1e9 / count);
+
+	benchmark_timezone("date_add", date_add<uint8_t>, t, count);
+	benchmark_timezone("addTimezone", time_date_tools_add, t, count);
+}
+
+int main(int argc, char *argv[])
+{
+	const uint32_t minutes = (argc > 1) ? strtoul(argv[1], NULL, 10) : 60;
+	const double cpu_ppm = (argc > 2) ? atof(argv[2]) : 0.0;
+	const double trim = (argc > 3) ? atof(argv[3]) : 0.0;
+
+	uint16_t failed = 0;
+	failed += check_encoder();
+	failed += check_dst();
+	failed += check_epoch();
+	failed += check_timezone("date_add", date_add<uint8_t>);
+	failed += check_timezone("addTimezone", time_date_tools_add);
+	failed += check_loopback();
+	failed += check_dual();
+	failed += check_timer2();
+	failed += check_leap();
+	failed += check_drift();
+	failed += check_pps();
+	failed += check_status();
+	failed += check_tasks();
+	failed += check_nmea();
+	failed += check_ntp();
+	failed += check_transmitter(minutes, cpu_ppm, trim);
+	benchmark();
+
+	printf("%s\n", failed ? "FAILED" : "PASSED");
+	return failed;
+}
@@ -87,9 +87,11 @@ ATtiny85   | *USE_OC1B | D4 / PB4 (pin 3)
 -----------+-----------+-----------------
 ATmega32u4 | *USE_OC1A | D9
 ATmega32u4 |  USE_OC1B | D10
+ATmega32u4 |  both     | D9 + D10 (two coils or an H-bridge, see set_output_b())
 -----------+-----------+-----------------
 ATmega328p | *USE_OC1A | D9
 ATmega328p |  USE_OC1B | D10
+ATmega328p |  both     | D9 + D10 (two coils or an H-bridge, see set_output_b())
 -----------+-----------+-----------------
 
 * Default setup
@@ -100,32 +102,255 @@ ATmega328p |  USE_OC1B | D10
 
 bool sync_gpstime = true;
 
-uint32_t t0;
+#include <TimeDateTools.h> // include before ATtinyGPS.h
+// ISR timing instrumentation (ATmega only)
+// Records the Timer1 overflow interrupt latency / duration in CPU cycles, printed with _DEBUG > 0
+// 0 = off
+// 1 = on
+#define WWVB_ISR_STATS 0
+// Loopback self check, the ISR traces what it emitted and wwvb_tx.update() decodes it like a clock
+// Counts the seconds that late interrupts (display, GPS) pushed out of the pulse width tolerance
+// 0 = off
+// 1 = on (240 bytes of RAM)
+#define WWVB_LOOPBACK 0
+// Resync drift telemetry, the transmitted second is timed against the GPS second at every resync
+// and without a GPS PPS the rate error is taken out of the calibration (see wwvb_frame.h)
+// 0 = off
+// 1 = on
+#define WWVB_DRIFT 1
+// Reduced power level, pulse width in percent of the high level
+// 0 = carrier off (most clocks decode this fine)
+// WWVB_PWM_LOW_TRUE = the level of the real transmitter, WWVB -17dB (DCF77 15%, JJY 10%, MSF off)
+#define WWVB_PWM_LOW 0
+#include <wwvb_frame.h> // include before ATtinyGPS.h, includes date_table.h (date_add())
+
+// Time code standard, the signal your clock is built for (see timecode.h)
+// TIMECODE_WWVB  : WWVB 60kHz (USA)
+// TIMECODE_DCF77 : DCF77 77.5kHz (Germany)
+// TIMECODE_JJY40 : JJY 40kHz (Japan, east)
+// TIMECODE_JJY60 : JJY 60kHz (Japan, west)
+// TIMECODE_MSF   : MSF 60kHz (UK)
+// TIMECODE_BPC   : BPC 68.5kHz (China)
+// TIMECODE_ROUND_ROBIN : the standards in tx_rotation_slots take turns, tx_rotation minutes each
+// Note : set wwvb_timezone to the time the clock expects e.g. DCF77 = UTC+1, JJY = UTC+9, BPC = UTC+8
+#define TIMECODE TIMECODE_WWVB
+timecode_tx<TIMECODE> wwvb_tx;
+
+#if (TIMECODE == TIMECODE_ROUND_ROBIN)
+// Standard, timezone added to the GPS time for it (as wwvb_tx.setTimezone(), wwvb_timezone is not used)
+// The Timer1 TOP is switched to each carrier on the minute boundary
+// Note : most clocks want a few good frames in a row, use windows of several minutes and CONTINUOUS_TX 1
+const timecode_slot tx_rotation_slots[] PROGMEM = {
+	{TIMECODE_WWVB, 6, 0},   // CST (UTC -6:00) + 6 = UTC
+	{TIMECODE_DCF77, 7, 0},  // CET (UTC +1:00)
+	{TIMECODE_JJY60, 15, 0}  // JST (UTC +9:00)
+	};
+timecode_rotation tx_rotation(tx_rotation_slots, sizeof(tx_rotation_slots) / sizeof(tx_rotation_slots[0]), 10);
+#endif
 
-#include <TimeDateTools.h> // include before wwvb.h AND/OR ATtinyGPS.h
-#include <wwvb.h> // include before ATtinyGPS.h
-wwvb wwvb_tx;
+// Daylight saving time rule for the DST bits, evaluated every minute on the local GPS time (see timecode_dst.h)
+// TIMECODE_DST_NONE : standard time only
+// TIMECODE_DST_US, TIMECODE_DST_EU or TIMECODE_DST_AU : summer time is sent and the clock adds the hour itself
+// Note : with a rule set local_timezone to the standard time (e.g. ACST = UTC +9:30)
+#define DST_RULE TIMECODE_DST_NONE
+
+// Resonator calibration in EEPROM (see wwvb_calibration.h)
+// 0 = off
+// 1 = the trim learned from the GPS PPS (or the resync drift) is saved once it settles, and loaded at boot
+#define WWVB_CALIBRATION 0
+#if (WWVB_CALIBRATION == 1)
+#include <wwvb_calibration.h>
+wwvb_calibration calibration;
+#endif
 
 // The ISR sets the PWM pulse width to correspond with the WWVB bit
+// Note : the frame is precomputed by wwvb_tx.update() in loop(), the ISR only indexes it
 ISR(TIMER1_OVF_vect)
 {
 	wwvb_tx.interrupt_routine();
 }
 
+// GPS PPS (pulse per second) input, disciplines the wwvb second boundaries to the GPS edge
+// 0 : no PPS (use calibrate()), 2 or 3 : PPS on INT0/INT1 (INT1/INT0 on the 32u4)
+// Note : on the Nano the LCD uses D2/D3, move LCD DC/CE before enabling PPS
+#define GPS_PPS_PIN 0
+
+#if (WWVB_CALIBRATION == 1) & (GPS_PPS_PIN == 0) & (WWVB_DRIFT == 0)
+#error WWVB_CALIBRATION learns the trim from the GPS PPS or the resync drift, set GPS_PPS_PIN or WWVB_DRIFT 1
+#endif
+
+#if (GPS_PPS_PIN > 0)
+void pps_interrupt()
+{
+	wwvb_tx.pps_interrupt();
+}
+#endif
+
+// GPS serial
+// GPS_SERIAL 0 : SoftwareSerial, its pin change interrupts are disabled while wwvb transmits
+// GPS_SERIAL 1 : HardwareSerial
+// GPS_SERIAL 2 : gps_uart.h, USART RX interrupt into a small ring buffer
+// Note : GPS_SERIAL 1 or 2 uses Serial1 on the 32u4 and Serial on the 328p (GPS Tx => RX1, set _DEBUG 0)
+#define GPS_SERIAL 0
+
+// CONTINUOUS_TX 0 : wwvb transmits for 9 minutes then stops for a minute to resync with GPS
+// CONTINUOUS_TX 1 : wwvb transmits continuously while the GPS time is read in the background
+//                   and checked against the wwvb time every minute (needs GPS_SERIAL 1 or 2)
+#define CONTINUOUS_TX 0
+
+#if (CONTINUOUS_TX == 1) & (GPS_SERIAL == 0)
+#error CONTINUOUS_TX needs the GPS on a hardware UART, set GPS_SERIAL 1 or 2
+#endif
+
+// Holdover time source, a battery backed DS3231 RTC on the I2C pins (see rtc_ds3231.h)
+// HOLDOVER_RTC 0 : nothing is transmitted until the GPS has a fix
+// HOLDOVER_RTC 1 : from boot the RTC time is transmitted (holdover) until the GPS has a fix, then the GPS
+//                  time takes over at a minute boundary and is written back to the RTC (needs CONTINUOUS_TX 1)
+#define HOLDOVER_RTC 0
+
+#if (HOLDOVER_RTC == 1)
+#if (CONTINUOUS_TX == 0)
+#error HOLDOVER_RTC hands over to the GPS while transmitting, set CONTINUOUS_TX 1
+#endif
+#if (defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)) & (GPS_PPS_PIN > 0)
+#error The 32u4 I2C pins are D2/D3, move the GPS PPS or set HOLDOVER_RTC 0
+#endif
+#include <rtc_ds3231.h>
+rtc_ds3231 rtc;
+bool holdover = false; // transmitting the RTC time
+uint8_t rtc_ss = 0xFF; // the RTC second at the last poll
+#endif
+
+#if (GPS_SERIAL == 0)
 #include <SoftwareSerial.h>
 #if defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)
 SoftwareSerial ttl(10, 6);// Rx, Tx pin
 #else
 SoftwareSerial ttl(7, 6);// Rx, Tx pin
 #endif
+#else
+#if !(defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)) & (_DEBUG > 0)
+#error The GPS uses Serial, set _DEBUG 0
+#endif
+#if (GPS_SERIAL == 2)
+#include <gps_uart.h>
+gps_uart ttl;
+
+// The ISR only moves the received byte into the ring buffer
+ISR(GPS_UART_RX_vect)
+{
+	ttl.interrupt_routine();
+}
+#elif defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)
+HardwareSerial &ttl = Serial1;
+#else
+HardwareSerial &ttl = Serial;
+#endif
+#endif
 
-#define GPS_MODULE 0 // ublox : Flash 16,812 bytes, SRAM 1299 bytes
-//#define GPS_MODULE 1 // mediatek (default) : Flash 16,138 bytes, SRAM 1053 bytes
+#define GPS_MODULE 0 // ublox
+//#define GPS_MODULE 1 // mediatek (default)
+// Note : the flash / SRAM / stack of each option and board is in the extras/footprint report
 
 #include <ATtinyGPS.h>
 ATtinyGPS gps;
 
+// Only the RMC and GGA sentences reach gps.parse(), the rest are dropped after the header
+//#define NMEA_SENTENCES (NMEA_RMC | NMEA_GGA)
+#include <nmea_filter.h>
+nmea_filter nmea;
+
+// 1 : tell the GPS module to stop sending the sentences that are filtered out
+#define NMEA_CONFIGURE 0
+
+// GPS bytes parsed per slice of loop() (9600 baud is ~1 byte/ms), the rest wait in the UART buffer
+#define GPS_PARSE_BUDGET 32
+
+#include <wwvb_tasks.h>
+extern wwvb_tasks tasks; // the task table is below the tasks, before loop()
+
+// SLEEP_IDLE 1 : idle the CPU between interrupts, Timer1 keeps generating the carrier
+#define SLEEP_IDLE 1
+
+// GPS_POWER_PIN > 0 : switches the GPS module supply (e.g. a P-channel MOSFET gate, LOW = on)
+// The GPS is off while wwvb transmits and powered up a minute before each resync
+// Note : CONTINUOUS_TX 1 keeps the GPS on
+// Note : the MCU Tx => GPS Rx line can back power the module, use a series resistor
+#define GPS_POWER_PIN 0
+#define GPS_POWER_ON LOW
+
+// Approximate supply current per mode, ATmega328p @ 16MHz/5V (datasheet / typical module figures)
+// -----------------------------+--------+----------------------+---------
+// Mode                         | MCU    | GPS (ublox 6M / MTK) | Total
+// -----------------------------+--------+----------------------+---------
+// busy loop, GPS always on     | ~10mA  | ~40mA / ~25mA        | 35-50mA
+// SLEEP_IDLE                   |  ~6mA  | ~40mA / ~25mA        | 31-46mA
+// SLEEP_IDLE + GPS_POWER_PIN   |  ~6mA  | on 2 of every 10 min | 11-14mA
+// -----------------------------+--------+----------------------+---------
+// Not included : power LED (~3mA), USB serial chip, LCD backlight, the coil
+// Note : the Timer1 overflow wakes the CPU every carrier cycle, so IDLE saves ~40% rather than ~70%
+
+#include <avr/sleep.h>
+#include <avr/power.h>
+
+void idle()
+{
+#if (SLEEP_IDLE == 1)
+	// wakes on the next interrupt (Timer1 overflow, millis(), GPS serial, PPS)
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sleep_cpu();
+	sleep_disable();
+#endif
+}
+
+void gpsPower(const bool on)
+{
+#if (GPS_POWER_PIN > 0)
+	digitalWrite(GPS_POWER_PIN, on ? GPS_POWER_ON : !GPS_POWER_ON);
+#endif
+}
+
+// TX_SCHEDULE 1 : only transmit inside the tx_windows (local time), standby with the GPS off outside them
+#define TX_SCHEDULE 0
+
+#if (TX_SCHEDULE == 1)
+#include <wwvb_schedule.h>
+
+// { start hh, start mm, end hh, end mm } e.g. when the clocks try to receive
+const wwvb_window tx_windows[] PROGMEM = { { 1, 0, 3, 30 } };
+wwvb_schedule schedule(tx_windows, sizeof(tx_windows) / sizeof(wwvb_window), 10); // GPS on 10 minutes early
+#endif
+
+// Returns false, and stands by, if the local time hh:mm:ss is outside the transmit windows
+bool transmitWindow(const uint8_t hh, const uint8_t mm, const uint8_t ss)
+{
+#if (TX_SCHEDULE == 1)
+	if (!schedule.in_window(hh, mm))
+	{
+		wwvb_tx.stop();
+		schedule.standby(hh, mm, ss);
+		gpsPower(false);
+		return false;
+	}
+#endif
+	return true;
+}
+
+// LCD_DRIVER 0 : Adafruit_PCD8544 + Adafruit_GFX (504 byte framebuffer)
+// LCD_DRIVER 1 : pcd8544_text.h, text only, glyphs are written straight to the LCD (no framebuffer)
+#define LCD_DRIVER 0
+
 #include <SPI.h>
+#if (LCD_DRIVER == 1)
+#include <pcd8544_text.h>
+
+#if defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)
+pcd8544_text nokia5110(A0, A1, A2); // HardwareSPI
+#else
+pcd8544_text nokia5110(2, 3, 4); // HardwareSPI
+#endif
+#else
 #include <Adafruit_GFX.h>
 #include <Adafruit_PCD8544.h>
 
@@ -134,6 +359,7 @@ Adafruit_PCD8544 nokia5110 = Adafruit_PCD8544(A0, A1, A2); // HardwareSPI
 #else
 Adafruit_PCD8544 nokia5110 = Adafruit_PCD8544(2, 3, 4); // HardwareSPI
 #endif
+#endif
 
 const int8_t local_timezone[2] = {10, 30};
 const int8_t wwvb_timezone[2] = {-6, 0};
@@ -142,37 +368,87 @@ void setup()
 {
 	wwvb_tx.setup();
 
+	// nothing uses the ADC, analog comparator or TWI (except HOLDOVER_RTC)
+	ADCSRA = 0;
+	power_adc_disable();
+	ACSR |= _BV(ACD);
+#if (HOLDOVER_RTC == 1)
+	rtc.begin();
+#elif defined(power_twi_disable)
+	power_twi_disable();
+#endif
+#if (GPS_POWER_PIN > 0)
+	pinMode(GPS_POWER_PIN, OUTPUT);
+	gpsPower(true);
+#endif
+
 	// Set the wwvb calibration values
-	// ATmega328p : _DEBUG = 0 or 1 : frametime for calibrate( 86, 86) = 60.000254s
-	// ATmega32u4 : _DEBUG = 0 or 1 : frametime for calibrate(-6,-6) = 59.999825s
-	wwvb_tx.setPWM_LOW(0);
-	wwvb_tx.calibrate(33,34); // 60.000017s
-	// calibration
-	//(0, 0) = 59.966523s (86, 86) = 60.052528s
-	// 60.052528/(0.086005 / 86) = 52.5249 - so calibrate to (86,86) - (53,52) = (33,34)
+	// The Timer1 TOP and carrier cycles per second are worked out from F_CPU at compile time,
+	// calibrate() trims that count for the resonator error (1 cycle ~ 17ppm @ 16MHz),
+	// calibrate_q16() in 1/65536 cycles for sub ppm steps
+	wwvb_tx.calibrate(0);
+#if (WWVB_CALIBRATION == 1)
+	// start from the trim learned on the last run
+	int32_t trim_q16;
+	if (calibration.load(trim_q16))
+	{
+		wwvb_tx.calibrate_q16(trim_q16);
+	}
+#endif
+#if (GPS_PPS_PIN > 0)
+	// the PPS edges trim the calibration continuously
+	pinMode(GPS_PPS_PIN, INPUT);
+	attachInterrupt(digitalPinToInterrupt(GPS_PPS_PIN), pps_interrupt, RISING);
+#endif
 
 	// set the timezone before you set your time
 	gps.setTimezone(local_timezone[0], local_timezone[1]); // set this to your local time e.g. (ACDT = UTC +10:30)
 	
 	// if you are using CST (UTC -6:00), set the timezone to +6,0
 	wwvb_tx.setTimezone(-wwvb_timezone[0], -wwvb_timezone[1]);
+
+	// summer time, DUT1 (UT1 - UTC in 0.1s, IERS Bulletin D) and the next leap second (IERS Bulletin C)
+	wwvb_tx.set_dst_rule(DST_RULE);
+	wwvb_tx.set_dut1(0);
+	wwvb_tx.set_leap_second(0, 0); // none announced
+#if (TIMECODE == TIMECODE_ROUND_ROBIN)
+	wwvb_tx.set_rotation(tx_rotation);
+#endif
+#if (WWVB_DRIFT == 1)
+	// the PPS disciplines the trim every second, otherwise the resync drift does
+	wwvb_tx.set_drift_auto(GPS_PPS_PIN == 0);
+#endif
+
+	// Set the default time to GPS epoch : 00:00 on 06/Jan/1980
+	wwvb_tx.clock.set(0, 0, 0, 6, 1, 80);
 	
 	ttl.begin(9600);
 
 	gps.setup(ttl);
+#if (NMEA_CONFIGURE == 1)
+	nmea_configure(ttl);
+#endif
 
+#if (LCD_DRIVER == 1)
+	nokia5110.begin(50);
+#else
 	nokia5110.begin();
 	nokia5110.setContrast(50);
 	nokia5110.setTextSize(1);
 	nokia5110.setTextColor(BLACK);
+#endif
+	clearLCD();
 
 	updateDisplay();
 #if (_DEBUG > 0)
 	Serial.begin(9600);
 	Serial.println("Start");
 #endif
+
+	startSync();
 }
 
+#if (GPS_SERIAL == 0)
 void disableSoftwareSerialRead()
 {
 	// Note : SoftwareSerial enables all pin change interrupt registers
@@ -229,148 +505,337 @@ void enableSoftwareSerialRead()
 	//          [  XTAL2|  XTAL1|    D13|    D11|    D12|    D10|     D9|     D8]
 #endif
 }
+#endif
 
-// Set the default time to GPS epoch : UTC 00:00 on 06/Jan/1980
-uint8_t ss = 0, mm = 0, hh = 0, DD = 6, MM = 1, YY = 80;
+// The LCD is 14 x 6 characters (6x8 pixel font), lcd_text is a copy of what is on screen
+// Only the characters that change are redrawn
+// * LCD_DRIVER 0 : with Adafruit_PCD8544's partial update display() only sends the columns/banks that were touched
+// * LCD_DRIVER 1 : each run of changed characters is written straight to its bank
+#define LCD_COLS 14
+#define LCD_ROWS 6
+char lcd_text[LCD_ROWS][LCD_COLS];
 
-void updateDisplay()
+void clearLine(char *line)
 {
-	nokia5110.clearDisplay();
-	nokia5110.setCursor(0, 0);
-	if (sync_gpstime)
+	memset(line, ' ', LCD_COLS);
+	line[LCD_COLS] = 0;
+}
+
+// zero padded 2 digit number
+void print2(char *dst, const uint8_t value)
+{
+	dst[0] = '0' + value / 10;
+	dst[1] = '0' + value % 10;
+}
+
+// right aligned number, blank padded
+void printRight(char *dst, uint8_t width, uint8_t value)
+{
+	do
+	{
+		dst[--width] = '0' + value % 10;
+		value /= 10;
+	} while ((value > 0) & (width > 0));
+}
+
+void updateLine(const uint8_t row, const char *line)
+{
+#if (LCD_DRIVER == 1)
+	uint8_t col = 0;
+	while (col < LCD_COLS)
 	{
-		// increment the internal time while wwvb is stopped (as it is syncing with gps)
-		addTimezone<uint8_t>(hh, mm, ss, DD, MM, YY, 0, 0, 1);
+		if (line[col] == lcd_text[row][col])
+		{
+			++col;
+			continue;
+		}
+		// write the run of changed characters with a single bank/column address
+		const uint8_t start = col;
+		while ((col < LCD_COLS) && (line[col] != lcd_text[row][col]))
+		{
+			lcd_text[row][col] = line[col];
+			++col;
+		}
+		nokia5110.print(start, row, line + start, col - start);
 	}
-	else
+#else
+	for (uint8_t col = 0; col < LCD_COLS; ++col)
+	{
+		if (line[col] != lcd_text[row][col])
+		{
+			nokia5110.drawChar(col * 6, row * 8, line[col], BLACK, WHITE, 1);
+			lcd_text[row][col] = line[col];
+		}
+	}
+#endif
+}
+
+void clearLCD()
+{
+	memset(lcd_text, ' ', sizeof(lcd_text));
+#if (LCD_DRIVER == 1)
+	nokia5110.clear();
+#else
+	nokia5110.clearDisplay();
+	nokia5110.display();
+#endif
+}
+
+const char gps_quality[9][10] PROGMEM = {
+	"  Invalid", "      GPS", "     DGPS", "      PPS", "      RTK",
+	"float RTK", "DEAD RECN", "   MANUAL", "SIMULATED" };
+
+void updateDisplay()
+{
+	char line[LCD_COLS + 1];
+
+	// local time : ticked by the wwvb ISR while transmitting, counted on millis() while stopped
+	uint8_t hh, mm, ss, DD, MM, YY;
+	wwvb_tx.clock.update();
+	wwvb_tx.clock.get(hh, mm, ss, DD, MM, YY);
+#if (DST_RULE != TIMECODE_DST_NONE)
+	// the clock keeps the standard time, show the summer time
+	if (timecode_dst_flags(DST_RULE, hh, mm, DD, MM, YY) & TIMECODE_DST)
 	{
-		// get the time from the wwvb state
-		hh = wwvb_tx.hh();
-		mm = wwvb_tx.mm();
-		ss = wwvb_tx.ss();
-		DD = wwvb_tx.DD();
-		MM = wwvb_tx.MM();
-		YY = wwvb_tx.YY();
-		
-		// Convert wwvb time transmitted time to local time
-		addTimezone<uint8_t>(hh, mm, ss, DD, MM, YY, wwvb_timezone[0], wwvb_timezone[1], 0);
+		wwvb_tx.clock.get(hh, mm, ss, DD, MM, YY, 3600);
 	}
-	// line 1
-	//nokia5110.print("   HH:MM:SS   ");
-	nokia5110.print("   ");
-	if (hh < 10) { nokia5110.print(0); } // zero pad
-	nokia5110.print(hh); nokia5110.print(":");
-	if (mm < 10) { nokia5110.print(0); } // zero pad
-	nokia5110.print(mm); nokia5110.print(":");
-	if (ss < 10) { nokia5110.print(0); } // zero pad
-	nokia5110.println(ss);
-	// line 2
-	//nokia5110.print("  DD/MM/YYYY  ");
-	nokia5110.print("  ");
-	if (DD < 10) { nokia5110.print(0); } // zero pad
-	nokia5110.print(DD); nokia5110.print("/");
-	if (MM < 10) { nokia5110.print(0); } // zero pad
-	nokia5110.print(MM); nokia5110.print("/");
-	if (YY < 80) { nokia5110.print(20); } // year pad ;)
-	else { nokia5110.print(19); }
-	if (YY < 10) { nokia5110.print(0); } // zero pad
-	nokia5110.println(YY);
-	// line 3
-	nokia5110.println("");
-	// line 4
-	nokia5110.print("WWVB: ");
+#endif
+	// line 1 : "   HH:MM:SS   "
+	clearLine(line);
+	print2(line + 3, hh); line[5] = ':';
+	print2(line + 6, mm); line[8] = ':';
+	print2(line + 9, ss);
+	updateLine(0, line);
+	// line 2 : "  DD/MM/YYYY  "
+	clearLine(line);
+	print2(line + 2, DD); line[4] = '/';
+	print2(line + 5, MM); line[7] = '/';
+	print2(line + 8, (YY < 80) ? 20 : 19); // year pad ;)
+	print2(line + 10, YY);
+	updateLine(1, line);
+	// line 3 : "TX errors: NN", bad seconds in the last minute
+#if (WWVB_LOOPBACK == 1)
+	clearLine(line);
+	wwvb_loopback_stats loopback;
+	wwvb_tx.get_loopback(loopback);
+	strcpy_P(line, PSTR("TX errors:"));
+	line[10] = ' ';
+	printRight(line + 11, 2, loopback.last_minute);
+	updateLine(2, line);
+#endif
+	// line 4 : "WWVB: Running"
+	clearLine(line);
 	if (wwvb_tx.is_active())
 	{
-		nokia5110.print("Running");
+		strcpy_P(line, PSTR("WWVB: Running"));
+#if (HOLDOVER_RTC == 1)
+		if (holdover)
+		{
+			strcpy_P(line, PSTR("WWVB:Holdover"));
+		}
+#endif
 	}
 	else if (sync_gpstime)
 	{
-		nokia5110.print("Syncing");
+		strcpy_P(line, PSTR("WWVB: Syncing"));
+	}
+#if (TX_SCHEDULE == 1)
+	else if (schedule.is_standby())
+	{
+		strcpy_P(line, PSTR("WWVB: Standby"));
 	}
+#endif
 	else
 	{
-		nokia5110.print("    Off");
+		strcpy_P(line, PSTR("WWVB:     Off"));
 	}
-	// line 5
-	nokia5110.print("Satellites:");
-	if (gps.satellites < 10) { nokia5110.print(" "); }
-	nokia5110.print(gps.satellites);
-	// line 6
-	nokia5110.print("Fix:");
-	if (gps.quality == 0)
+	line[13] = ' ';
+	updateLine(3, line);
+	// line 5 : "Satellites:NN"
+	clearLine(line);
+	strcpy_P(line, PSTR("Satellites:"));
+	line[11] = ' ';
+	printRight(line + 11, 2, gps.satellites);
+	updateLine(4, line);
+	// line 6 : "Fix:      GPS"
+	clearLine(line);
+	strcpy_P(line, PSTR("Fix:"));
+	line[4] = ' ';
+	if (gps.quality <= 8)
 	{
-		nokia5110.print("  Invalid");
+		strcpy_P(line + 4, gps_quality[gps.quality]);
 	}
-	else
+	line[13] = ' ';
+	updateLine(5, line);
+
+#if (LCD_DRIVER == 0)
+	nokia5110.display();
+#endif
+}
+
+// Encode the next minute's frame, once a minute the learned trim is checked for saving
+void updateFrame()
+{
+#if (WWVB_CALIBRATION == 1)
+	if (wwvb_tx.update())
+	{
+#if (WWVB_DRIFT == 1)
+		// disciplined by the PPS, or the resync drift has settled
+		calibration.update(wwvb_tx.trim_q16(), (wwvb_tx.pps_good_seconds() >= 50) | wwvb_tx.drift_settled());
+#else
+		calibration.update(wwvb_tx.trim_q16(), wwvb_tx.pps_good_seconds() >= 50);
+#endif
+	}
+#else
+	wwvb_tx.update();
+#endif
+}
+
+#if (HOLDOVER_RTC == 1)
+// Until the GPS has a fix, start transmitting the RTC time on its next minute boundary
+// The RTC is polled every 10ms, so the transmitted second is within ~10ms of the RTC second
+void holdoverStart()
+{
+	static uint32_t t_poll = 0;
+#if (TX_SCHEDULE == 1)
+	if (schedule.is_standby())
+	{
+		return;
+	}
+#endif
+	if (millis() - t_poll < 10)
+	{
+		return;
+	}
+	t_poll = millis();
+
+	uint8_t hh, mm, ss, DD, MM, YY;
+	if (!rtc.read_ss(ss))
+	{
+		return;
+	}
+	const bool minute = (ss == 0) & (rtc_ss != 0) & (rtc_ss != 0xFF);
+	rtc_ss = ss;
+	if (!minute)
+	{
+		return;
+	}
+
+	// no times from an RTC that has lost power
+	if (rtc.read(hh, mm, ss, DD, MM, YY))
 	{
-		switch (gps.quality)
+		wwvb_tx.clock.set(hh, mm, 0, DD, MM, YY);
+		if (transmitWindow(hh, mm, 0))
 		{
-		case 1:
-			nokia5110.print("      GPS"); break;
-		case 2:
-			nokia5110.print("     DGPS"); break;
-		case 3:
-			nokia5110.print("      PPS"); break;
-		case 4:
-			nokia5110.print("      RTK"); break;
-		case 5:
-			nokia5110.print("float RTK"); break;
-		case 6:
-			nokia5110.print("DEAD RECN"); break;
-		case 7:
-			nokia5110.print("   MANUAL"); break;
-		case 8:
-			nokia5110.print("SIMULATED"); break;
+			wwvb_tx.set_time(hh, mm, DD, MM, YY);
+			wwvb_tx.start();
+			holdover = true;
+#if (_DEBUG > 0)
+			Serial.println(F("Start wwvb, RTC holdover"));
+#endif
 		}
 	}
-	nokia5110.display();
 }
+#endif
 
-void loop()
+// Start reading the GPS, taskGPS sets the time on its next 0s sentence
+void startSync()
 {
-	// if we are receiving gps data, parse it
-	if (sync_gpstime)
-	{
 #if (_DEBUG > 0)
-		Serial.println("Sync gps");
+	Serial.println("Sync gps");
+#endif
+#if (GPS_SERIAL == 0)
+	enableSoftwareSerialRead(); // enable SoftwareSerial pin change interrupts
+	ttl.listen(); // reset buffer status
+#endif
+	gps.new_data(); // clear gps.new_data
+	sync_gpstime = true;
+}
+
+// GPS task : parse up to GPS_PARSE_BUDGET bytes, the UART buffers the rest until the next slice
+void taskGPS()
+{
+#if (CONTINUOUS_TX == 0)
+	if (!sync_gpstime)
+	{
+		return; // the GPS isn't read while wwvb transmits
+	}
 #endif
-		t0 = millis(); // sync the internal arduino millis() to the wwvb sync time
-		enableSoftwareSerialRead(); // enable SoftwareSerial pin change interrupts
-		ttl.listen(); // reset buffer status
-		gps.new_data(); // clear gps.new_data
+	for (uint8_t n = 0; (n < GPS_PARSE_BUDGET) && ttl.available(); ++n)
+	{
+		nmea.parse(gps, ttl.read());
+	}
 
-		// wait until we get gps data
-		while (!(((gps.IsValid) | (gps.YY < 80)) & ((gps.ss == 0) & gps.new_data())))
+	// the gps sentence for 0s of the minute
+	if (gps.new_data() & (gps.ss == 0) & ((gps.IsValid) | (gps.YY < 80)))
+	{
+#if (WWVB_DRIFT == 1)
+		// how far the transmitted second has drifted from the GPS second, before the time is set from it
+		wwvb_tx.drift(date_to_seconds(gps.hh, gps.mm, gps.ss, gps.DD, gps.MM, gps.YY), nmea.burst_us());
+#endif
+#if (CONTINUOUS_TX == 1)
+		// Only corrects the wwvb time (at the next minute boundary) if it has drifted
+		if (transmitWindow(gps.hh, gps.mm, gps.ss))
 		{
-			while (ttl.available())
-			{
-				gps.parse(ttl.read());
-			}
-			// update display every 1s
-			if (millis() - t0 >= 1000)
-			{
-				t0 = millis();
-				updateDisplay();
-			}
+			wwvb_tx.sync_time(gps.hh, gps.mm, gps.DD, gps.MM, gps.YY);
 		}
-
+		else
+		{
+			wwvb_tx.clock.set(gps.hh, gps.mm, gps.ss, gps.DD, gps.MM, gps.YY); // standby, nothing ticks the clock
+		}
+#if (HOLDOVER_RTC == 1)
+		// the GPS has taken over, keep the RTC on its time (on the first fix, then hourly)
+		if (sync_gpstime | (gps.mm == 0))
+		{
+			rtc.write(gps.hh, gps.mm, gps.ss, gps.DD, gps.MM, gps.YY);
+		}
+		holdover = false;
+#endif
+		sync_gpstime = false;
+#else
+#if (GPS_SERIAL == 0)
 		// disable the pin change interrupts that SoftwareSerial uses to read data
 		// as it interferes with the wwvb timing
 		ttl.stopListening();
 		disableSoftwareSerialRead(); // disable SoftwareSerial pin change interrupts
+#endif
+
+		// the clock keeps the local time for the display/schedule, wwvb_tx ticks it while transmitting
+		wwvb_tx.clock.set(gps.hh, gps.mm, gps.ss, gps.DD, gps.MM, gps.YY);
 
-		// Yeah im ignoring the last parameter to set whether we are in daylight savings time
-		wwvb_tx.set_time(gps.hh, gps.mm, gps.DD, gps.MM, gps.YY);
-		wwvb_tx.start();
+		// the DST bits come from DST_RULE, worked out by wwvb_tx for every minute
+		if (transmitWindow(gps.hh, gps.mm, gps.ss))
+		{
+			wwvb_tx.set_time(gps.hh, gps.mm, gps.DD, gps.MM, gps.YY);
+			wwvb_tx.start();
+		}
 #if (_DEBUG > 0)
 		Serial.println("Start wwvb");
 #endif
 		sync_gpstime = false;
-		t0 = millis(); // sync the internal arduino millis() to the wwvb sync time
+		gpsPower(false); // not needed until the next resync
+#endif
+	}
+#if (HOLDOVER_RTC == 1)
+	else if (sync_gpstime & !wwvb_tx.is_active())
+	{
+		holdoverStart();
 	}
+#endif
+}
 
+// Sync supervision task : the resync cycle and the transmit windows
+void taskSync()
+{
+#if (CONTINUOUS_TX == 0)
 	if (!sync_gpstime)
 	{
+		// power the GPS up a minute before the resync so it has a fix when it is needed
+		if ((wwvb_tx.mm() % 10 == 8) & wwvb_tx.is_active())
+		{
+			gpsPower(true);
+		}
+
 		// Note
 		// * wwvb time is synced and wwvb transmission is started when minutes = 0,10,20,30,40 or 50
 		// * wwvb transmission is stopped when minutes = 9,19,29,39,49 or 59
@@ -381,16 +846,56 @@ void loop()
 		{
 #if (_DEBUG > 0)
 			Serial.println("Stop wwvb");
+#if (WWVB_ISR_STATS == 1)
+			wwvb_tx.print_stats(Serial);
+			wwvb_tx.reset_stats();
+#endif
+#if (WWVB_LOOPBACK == 1)
+			wwvb_tx.print_loopback(Serial);
+#endif
+#if (WWVB_DRIFT == 1)
+			wwvb_tx.print_drift(Serial);
+#endif
+			tasks.print_stats(Serial);
+			tasks.reset_stats();
 #endif
 			wwvb_tx.stop();
-			sync_gpstime = true;
+			startSync();
 		}
 	}
+#endif
+
+#if (TX_SCHEDULE == 1)
+	// stop at the end of a transmit window
+	if (wwvb_tx.is_active() & (wwvb_tx.ss() == 0))
+	{
+		uint8_t hh, mm, ss, DD, MM, YY;
+		wwvb_tx.clock.get(hh, mm, ss, DD, MM, YY); // local time
+		transmitWindow(hh, mm, ss);
+	}
 
-	// update display every 1s
-	if (millis() - t0 >= 1000)
+	// resync with the GPS ahead of the next window
+	if (schedule.wake())
 	{
-		t0 = millis();
-		updateDisplay();
+		gpsPower(true);
+		startSync();
 	}
+#endif
+}
+
+// Foreground tasks (see wwvb_tasks.h), period / phase in 100ms slots of the transmitted second
+// * the GPS parser and the frame encoder run on every slice
+// * the display is pushed once a second, in the slot the second starts
+const wwvb_task tasks_table[] PROGMEM = {
+	{ taskGPS, 0, 0, 2 },
+	{ updateFrame, 0, 0, 5 },
+	{ taskSync, 1, 0, 1 },
+	{ updateDisplay, WWVB_TASK_SLOTS, 0, 20 }
+	};
+wwvb_tasks tasks(tasks_table, sizeof(tasks_table) / sizeof(tasks_table[0]), wwvb_tx.clock);
+
+void loop()
+{
+	tasks.run();
+	idle();
 }
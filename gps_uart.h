@@ -0,0 +1,152 @@
+#ifndef GPS_UART_H
+#define GPS_UART_H
+
+/*
+gps_uart : interrupt driven hardware USART receiver for the GPS
+
+The RX complete interrupt only copies UDR into a small ring buffer, so it is
+a handful of cycles per byte and never blocks the wwvb Timer1 interrupt
+(SoftwareSerial disables interrupts for a whole byte time, ~1ms at 9600 baud).
+
+Usage :
+	gps_uart gps_rx;
+	ISR(GPS_UART_RX_vect)
+	{
+		gps_rx.interrupt_routine();
+	}
+
+Note : this replaces the Arduino HardwareSerial on the same USART, do not use
+Serial1 (ATmega32u4) / Serial (ATmega328p) anywhere else in the sketch
+
+-----------+-------+--------------
+Chip       | USART | GPS Tx => Rx
+-----------+-------+--------------
+ATmega32u4 | USART1| D0 / RX1
+ATmega328p | USART0| D0 / RX
+-----------+-------+--------------
+*/
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+
+// Ring buffer size, must be a power of 2
+// At 9600 baud loop() must read the buffer at least every GPS_UART_BUFFER ms
+#ifndef GPS_UART_BUFFER
+#define GPS_UART_BUFFER 32
+#endif
+
+#if defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__)
+#define GPS_UART_RX_vect USART1_RX_vect
+#define GPS_UDR UDR1
+#define GPS_UCSRA UCSR1A
+#define GPS_UCSRB UCSR1B
+#define GPS_UCSRC UCSR1C
+#define GPS_UBRR UBRR1
+#define GPS_U2X U2X1
+#define GPS_UDRE UDRE1
+#define GPS_RXEN RXEN1
+#define GPS_TXEN TXEN1
+#define GPS_RXCIE RXCIE1
+#define GPS_UCSZ0 UCSZ10
+#define GPS_UCSZ1 UCSZ11
+#elif defined(__AVR_ATmega168__) | defined(__AVR_ATmega168P__) | defined(__AVR_ATmega328P__)
+#define GPS_UART_RX_vect USART_RX_vect
+#define GPS_UDR UDR0
+#define GPS_UCSRA UCSR0A
+#define GPS_UCSRB UCSR0B
+#define GPS_UCSRC UCSR0C
+#define GPS_UBRR UBRR0
+#define GPS_U2X U2X0
+#define GPS_UDRE UDRE0
+#define GPS_RXEN RXEN0
+#define GPS_TXEN TXEN0
+#define GPS_RXCIE RXCIE0
+#define GPS_UCSZ0 UCSZ00
+#define GPS_UCSZ1 UCSZ01
+#else
+#error gps_uart.h : no hardware USART for this chip
+#endif
+
+class gps_uart : public Stream
+{
+private:
+	uint8_t _buffer[GPS_UART_BUFFER];
+	volatile uint8_t _head;
+	volatile uint8_t _tail;
+	volatile uint8_t _overflow;
+public:
+	gps_uart() : _head(0), _tail(0), _overflow(0) {}
+
+	// 8N1, double speed mode (better baud rate match at 8/16MHz)
+	void begin(const uint32_t baud)
+	{
+		GPS_UCSRA = _BV(GPS_U2X);
+		GPS_UBRR = ((F_CPU / 4 / baud) - 1) / 2;
+		GPS_UCSRC = _BV(GPS_UCSZ1) | _BV(GPS_UCSZ0);
+		GPS_UCSRB = _BV(GPS_RXEN) | _BV(GPS_TXEN) | _BV(GPS_RXCIE);
+	}
+
+	void end()
+	{
+		GPS_UCSRB = 0;
+		_head = _tail;
+	}
+
+	// Bytes dropped because loop() did not keep up
+	uint8_t overflow() { return _overflow; }
+
+	virtual int available()
+	{
+		return static_cast<uint8_t>(_head - _tail) & (GPS_UART_BUFFER - 1);
+	}
+
+	virtual int peek()
+	{
+		if (_head == _tail)
+		{
+			return -1;
+		}
+		return _buffer[_tail];
+	}
+
+	virtual int read()
+	{
+		if (_head == _tail)
+		{
+			return -1;
+		}
+		const uint8_t c = _buffer[_tail];
+		_tail = (_tail + 1) & (GPS_UART_BUFFER - 1);
+		return c;
+	}
+
+	// Polled transmit, only used to send the GPS module its configuration
+	virtual size_t write(uint8_t c)
+	{
+		while (!(GPS_UCSRA & _BV(GPS_UDRE)));
+		GPS_UDR = c;
+		return 1;
+	}
+
+	virtual void flush() {}
+
+	using Print::write;
+
+	// Call from ISR(GPS_UART_RX_vect)
+	inline void interrupt_routine()
+	{
+		const uint8_t c = GPS_UDR;
+		const uint8_t next = (_head + 1) & (GPS_UART_BUFFER - 1);
+		if (next != _tail)
+		{
+			_buffer[_head] = c;
+			_head = next;
+		}
+		else
+		{
+			++_overflow;
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef NMEA_FILTER_H
+#define NMEA_FILTER_H
+
+/*
+nmea_filter : sentence filter in front of ATtinyGPS::parse()
+
+The sketches only use the time, date, fix and satellite count (RMC and GGA).
+The filter holds the 6 character sentence header ($ttSSS), then either replays it
+into the parser and passes the rest of the sentence through, or drops every
+byte up to the next '$' without any field tokenization.
+
+#define NMEA_SENTENCES before including this file to change the mask
+e.g. #define NMEA_SENTENCES (NMEA_RMC | NMEA_GGA | NMEA_ZDA)
+
+burst_us() is the micros() the first '$' after a quiet line (NMEA_IDLE_MS) was read,
+i.e. the start of the sentences the GPS sends for its second, a timestamp of the
+GPS second that is late by the module latency plus how long the byte waited in loop().
+
+nmea_configure() optionally tells the GPS module to stop sending the unused
+sentences, which also cuts the serial interrupt load
+*/
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+
+#define NMEA_RMC  0x01
+#define NMEA_GGA  0x02
+#define NMEA_GSA  0x04
+#define NMEA_GSV  0x08
+#define NMEA_GLL  0x10
+#define NMEA_VTG  0x20
+#define NMEA_ZDA  0x40
+#define NMEA_PUBX 0x80 // ublox proprietary
+#define NMEA_ALL  0xFF
+
+#ifndef NMEA_SENTENCES
+#define NMEA_SENTENCES (NMEA_RMC | NMEA_GGA)
+#endif
+
+// Returns the mask bit for the sentence header $ttSSS (0 if unknown)
+inline uint8_t nmea_sentence(const char *head)
+{
+	if ((head[1] == 'P') & (head[2] == 'U'))
+	{
+		return NMEA_PUBX;
+	}
+	const char *id = head + 3;
+	switch (id[0])
+	{
+	case 'R': return ((id[1] == 'M') & (id[2] == 'C')) ? NMEA_RMC : 0;
+	case 'G':
+		if (id[1] == 'G') { return (id[2] == 'A') ? NMEA_GGA : 0; }
+		if (id[1] == 'L') { return (id[2] == 'L') ? NMEA_GLL : 0; }
+		if (id[1] == 'S') { return (id[2] == 'A') ? NMEA_GSA : ((id[2] == 'V') ? NMEA_GSV : 0); }
+		return 0;
+	case 'V': return ((id[1] == 'T') & (id[2] == 'G')) ? NMEA_VTG : 0;
+	case 'Z': return ((id[1] == 'D') & (id[2] == 'A')) ? NMEA_ZDA : 0;
+	}
+	return 0;
+}
+
+#define NMEA_HEADER 6
+#define NMEA_IDLE_MS 50 // sentences for a second are back to back, the line is quiet between seconds
+#define NMEA_PASS 0xFE
+#define NMEA_DISCARD 0xFF
+
+class nmea_filter
+{
+private:
+	char _head[NMEA_HEADER];
+	uint8_t _pos;
+	uint32_t _t_byte; // millis() of the last byte
+	uint32_t _burst_us;
+public:
+	nmea_filter() : _pos(NMEA_DISCARD), _t_byte(0), _burst_us(0) {}
+
+	// micros() at the start of the last burst of sentences
+	uint32_t burst_us() { return _burst_us; }
+
+	// Use in place of gps.parse(c)
+	template <typename GPS>
+	inline void parse(GPS &gps, const char c)
+	{
+		const uint32_t t = millis();
+		const bool idle = (t - _t_byte >= NMEA_IDLE_MS);
+		_t_byte = t;
+		if (c == '$')
+		{
+			if (idle)
+			{
+				_burst_us = micros();
+			}
+			_head[0] = c;
+			_pos = 1;
+			return;
+		}
+		if (_pos == NMEA_DISCARD)
+		{
+			return; // fast path, not a sentence we want
+		}
+		if (_pos == NMEA_PASS)
+		{
+			gps.parse(c);
+			return;
+		}
+
+		_head[_pos++] = c;
+		if (_pos == NMEA_HEADER)
+		{
+			if (nmea_sentence(_head) & (NMEA_SENTENCES))
+			{
+				for (uint8_t i = 0; i < NMEA_HEADER; ++i)
+				{
+					gps.parse(_head[i]);
+				}
+				_pos = NMEA_PASS;
+			}
+			else
+			{
+				_pos = NMEA_DISCARD;
+			}
+		}
+	}
+};
+
+// Writes $<body>*<checksum>\r\n to the GPS module
+template <typename STREAM>
+class nmea_writer
+{
+private:
+	STREAM &_port;
+	uint8_t _checksum;
+public:
+	nmea_writer(STREAM &port) : _port(port), _checksum(0)
+	{
+		_port.write('$');
+	}
+
+	void write(const char c)
+	{
+		_checksum ^= c;
+		_port.write(c);
+	}
+
+	void write_P(const char *s)
+	{
+		char c;
+		while ((c = pgm_read_byte(s++)) != 0)
+		{
+			write(c);
+		}
+	}
+
+	void end()
+	{
+		const char hex[] = "0123456789ABCDEF";
+		_port.write('*');
+		_port.write(hex[_checksum >> 4]);
+		_port.write(hex[_checksum & 0x0F]);
+		_port.write('\r');
+		_port.write('\n');
+	}
+};
+
+#if defined(GPS_MODULE) && (GPS_MODULE == 0)
+// ublox : PUBX,40 sets the output rate of a sentence, 0 = off
+const char nmea_pubx40[] PROGMEM = "PUBX,40,";
+const char nmea_pubx40_off[] PROGMEM = ",0,0,0,0";
+const char nmea_pubx40_id[4][4] PROGMEM = { "GLL", "GSA", "GSV", "VTG" };
+const uint8_t nmea_pubx40_mask[4] PROGMEM = { NMEA_GLL, NMEA_GSA, NMEA_GSV, NMEA_VTG };
+
+template <typename STREAM>
+void nmea_configure(STREAM &port)
+{
+	for (uint8_t i = 0; i < 4; ++i)
+	{
+		if (!(pgm_read_byte(&nmea_pubx40_mask[i]) & (NMEA_SENTENCES)))
+		{
+			nmea_writer<STREAM> msg(port);
+			msg.write_P(nmea_pubx40);
+			msg.write_P(nmea_pubx40_id[i]);
+			msg.write_P(nmea_pubx40_off);
+			msg.end();
+		}
+	}
+}
+#else
+// mediatek : PMTK314 sets the output rate of each sentence (0 = off, 1 = every fix)
+// [GLL, RMC, VTG, GGA, GSA, GSV, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ZDA, 0]
+const char nmea_pmtk314[] PROGMEM = "PMTK314";
+const uint8_t nmea_pmtk314_mask[19] PROGMEM = { NMEA_GLL, NMEA_RMC, NMEA_VTG, NMEA_GGA, NMEA_GSA, NMEA_GSV,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, NMEA_ZDA, 0 };
+
+template <typename STREAM>
+void nmea_configure(STREAM &port)
+{
+	nmea_writer<STREAM> msg(port);
+	msg.write_P(nmea_pmtk314);
+	for (uint8_t i = 0; i < 19; ++i)
+	{
+		msg.write(',');
+		msg.write((pgm_read_byte(&nmea_pmtk314_mask[i]) & (NMEA_SENTENCES)) ? '1' : '0');
+	}
+	msg.end();
+}
+#endif
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef NMEA_TIME_H
+#define NMEA_TIME_H
+
+/*
+nmea_time : streaming NMEA time extractor, a small stand in for the parts of ATtinyGPS the sketches use
+
+Only the UTC time, date and status of $--RMC and the fix quality and satellite count
+of $--GGA are read, one character at a time into a few bytes of state, nothing of the
+sentence is buffered. Any talker (GP, GN, GL, ...) is accepted, the other sentences are
+skipped after the header. The fields only replace the published ones once the sentence
+checksum matches, so a byte lost by the serial reader never gives a wrong time.
+
+The public fields are the ATtinyGPS ones : hh, mm, ss, DD, MM, YY (UTC + setTimezone(),
+worked out with date_add()), IsValid (RMC status A), quality (GGA 0 - 8), satellites and
+new_data(), true once for every good RMC sentence.
+
+State : 28 bytes (with the published fields), no tables in RAM
+*/
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "date_table.h"
+
+#define NMEA_TIME_RMC 0x01
+#define NMEA_TIME_GGA 0x02
+#define NMEA_TIME_CHECKSUM 0xFF // _field while the two checksum digits are read
+
+const char nmea_time_rmc[3] PROGMEM = { 'R', 'M', 'C' };
+const char nmea_time_gga[3] PROGMEM = { 'G', 'G', 'A' };
+
+class nmea_time
+{
+private:
+	uint8_t _sentence; // NMEA_TIME_RMC / _GGA (both while the header is read), 0 : skip to the next '$'
+	uint8_t _field;
+	uint8_t _pos; // character in the field
+	uint8_t _checksum;
+	uint8_t _rx; // the received checksum
+
+	// this sentence, published when the checksum matches
+	uint8_t _t[3]; // hh mm ss
+	uint8_t _d[3]; // DD MM YY
+	uint8_t _got, _got_date; // digits of the time / date read, of 6
+	bool _valid;
+	uint8_t _quality, _satellites;
+
+	int8_t _tz_hh, _tz_mm;
+	bool _new_data;
+
+	static uint8_t hex(const char c)
+	{
+		return (c <= '9') ? c - '0' : (c & 0x07) + 9; // 'A' - 'F' or 'a' - 'f'
+	}
+
+	// hhmmss or ddmmyy into v[0..2], got counts the digits
+	void digits(uint8_t *v, uint8_t &got, const uint8_t d)
+	{
+		if (_pos >= 6)
+		{
+			return; // the decimals of the seconds
+		}
+		v[_pos >> 1] = (_pos & 1) ? v[_pos >> 1] + d : d * 10;
+		++got;
+	}
+
+	void header(const char c)
+	{
+		if ((_pos < 2) | (_pos > 4))
+		{
+			_sentence = (_pos < 2) ? _sentence : 0;
+			return;
+		}
+		if (c != static_cast<char>(pgm_read_byte(&nmea_time_rmc[_pos - 2])))
+		{
+			_sentence &= ~NMEA_TIME_RMC;
+		}
+		if (c != static_cast<char>(pgm_read_byte(&nmea_time_gga[_pos - 2])))
+		{
+			_sentence &= ~NMEA_TIME_GGA;
+		}
+	}
+
+	void field(const char c)
+	{
+		const uint8_t d = c - '0';
+		if (_sentence == NMEA_TIME_RMC)
+		{
+			switch (_field)
+			{
+			case 1: if (d <= 9) { digits(_t, _got, d); } break;
+			case 2: _valid = (c == 'A'); break;
+			case 9: if (d <= 9) { digits(_d, _got_date, d); } break;
+			}
+		}
+		else if (d <= 9)
+		{
+			switch (_field)
+			{
+			case 6: _quality = d; break;
+			case 7: _satellites = (_pos == 0) ? d : _satellites * 10 + d; break;
+			}
+		}
+	}
+
+	void publish()
+	{
+		if (_sentence == NMEA_TIME_GGA)
+		{
+			quality = _quality;
+			satellites = _satellites;
+			return;
+		}
+		if ((_got != 6) | (_got_date != 6) | (_t[0] > 23) | (_t[1] > 59) | (_t[2] > 60) |
+			(_d[0] == 0) | (_d[0] > 31) | (_d[1] == 0) | (_d[1] > 12))
+		{
+			return; // no time yet (empty fields before the first fix)
+		}
+		hh = _t[0]; mm = _t[1]; ss = _t[2];
+		DD = _d[0]; MM = _d[1]; YY = _d[2];
+		date_add<uint8_t>(hh, mm, ss, DD, MM, YY, _tz_hh, _tz_mm, 0);
+		IsValid = _valid;
+		_new_data = true;
+	}
+public:
+	uint8_t hh, mm, ss, DD, MM, YY;
+	bool IsValid;
+	uint8_t quality, satellites;
+
+	nmea_time() : _sentence(0), _field(0), _pos(0), _checksum(0), _rx(0), _tz_hh(0), _tz_mm(0), _new_data(false),
+		hh(0), mm(0), ss(0), DD(6), MM(1), YY(80), IsValid(false), quality(0), satellites(0) {}
+
+	// Nothing to configure, the module's default NMEA output is read (see nmea_configure())
+	template <typename STREAM>
+	void setup(STREAM &) {}
+
+	// Added to the UTC time of the GPS, e.g. (10, 30) for ACDT
+	void setTimezone(const int8_t tz_hh, const int8_t tz_mm)
+	{
+		_tz_hh = tz_hh;
+		_tz_mm = tz_mm;
+	}
+
+	// true once after each good RMC sentence
+	bool new_data()
+	{
+		const bool n = _new_data;
+		_new_data = false;
+		return n;
+	}
+
+	void parse(const char c)
+	{
+		if (c == '$')
+		{
+			_sentence = NMEA_TIME_RMC | NMEA_TIME_GGA;
+			_field = 0;
+			_pos = 0;
+			_checksum = 0;
+			_got = 0;
+			_got_date = 0;
+			_valid = false;
+			_quality = 0;
+			_satellites = 0;
+			return;
+		}
+		if (_sentence == 0)
+		{
+			return;
+		}
+		if (_field == NMEA_TIME_CHECKSUM)
+		{
+			_rx = (_rx << 4) | hex(c);
+			if (++_pos == 2)
+			{
+				if (_rx == _checksum)
+				{
+					publish();
+				}
+				_sentence = 0;
+			}
+			return;
+		}
+		if (c == '*')
+		{
+			_field = NMEA_TIME_CHECKSUM;
+			_pos = 0;
+			_rx = 0;
+			return;
+		}
+		if ((c == '\r') | (c == '\n'))
+		{
+			_sentence = 0; // no checksum, not trusted
+			return;
+		}
+		_checksum ^= c;
+		if (c == ',')
+		{
+			if ((_field == 0) & (_pos != 5))
+			{
+				_sentence = 0; // not a $ttSSS header
+				return;
+			}
+			++_field;
+			_pos = 0;
+			return;
+		}
+		if (_field == 0)
+		{
+			header(c);
+		}
+		else
+		{
+			field(c);
+		}
+		++_pos;
+	}
+};
+
+#endif
@@ -0,0 +1,252 @@
+#ifndef NTP_TIME_H
+#define NTP_TIME_H
+
+/*
+ntp_time : SNTP time source (RFC 4330) for the ESP32 / ESP8266, in place of the GPS
+
+A time source is anything with the fields the sync code of the sketches reads :
+hh, mm, ss, DD, MM, YY (local time, setTimezone()), IsValid and new_data(), true once
+for every new second. ATtinyGPS, nmea_time and ntp_time all have them, so the same
+"sync on the 0s second" code runs on any of them (see examples/ntp_time_sync).
+
+Every NTP_TIME_POLL_S a burst of NTP_TIME_SAMPLES requests goes to the server, 2s apart.
+Each reply has the four timestamps : T1 (request sent, micros()), T2 / T3 (server receive /
+transmit, UTC) and T4 (reply read, micros()). The round trip is (T4 - T1) - (T3 - T2), and
+with the delay the same both ways UTC at T4 is T3 + delay / 2, i.e. the start of the
+second is known in micros() to about half the difference between the two directions.
+The reply with the least round trip of a burst is kept (the others waited in a queue on
+the way, a Wi-Fi retry or a late poll()), so one good exchange of a burst is enough
+for a sub ms offset. Between bursts the seconds freewheel on micros().
+
+second_us() is the micros() at the start of the current second, the reference for
+wwvb_tx.drift() (the nmea_filter::burst_us() of the GPS sketches) : it has no serial or
+loop() latency in it, only the path asymmetry to the server.
+
+poll() reads the reply, so call it every loop(), a reply read late looks like a longer
+round trip and loses to the other samples of the burst.
+
+Usage :
+	WiFiUDP udp;
+	ntp_time ntp;
+	ntp.begin(udp);
+	...
+	ntp.poll(udp, "pool.ntp.org");
+	if (ntp.new_data() & (ntp.ss == 0) & ntp.IsValid) { ... }
+
+State : 48 bytes (with the public fields), the 48 byte packet is on the stack of poll()
+*/
+
+#include <Arduino.h>
+#include "date_table.h"
+
+#define NTP_TIME_PORT 123
+#define NTP_TIME_PACKET 48
+#define NTP_TIME_EPOCH_2000 3155673600UL // seconds from 1900 (NTP) to 2000 (date_table.h)
+
+#ifndef NTP_TIME_LOCAL_PORT
+#define NTP_TIME_LOCAL_PORT 4123
+#endif
+
+#ifndef NTP_TIME_POLL_S
+#define NTP_TIME_POLL_S 64 // between bursts, the NTP minimum poll
+#endif
+
+#ifndef NTP_TIME_SAMPLES
+#define NTP_TIME_SAMPLES 4 // requests a burst, the least round trip one is kept
+#endif
+
+#define NTP_TIME_GAP_MS 2000 // between the requests of a burst
+#define NTP_TIME_TIMEOUT_MS 1000
+#define NTP_TIME_DELAY_MAX_US 500000UL // a longer round trip is not used
+
+#ifndef NTP_TIME_HOLD_S
+#define NTP_TIME_HOLD_S 3600 // IsValid this long after the last good reply (the ESP32 crystal ~20ppm is 72ms)
+#endif
+
+class ntp_time
+{
+private:
+	uint32_t _seconds; // UTC seconds since 2000 of the current second
+	uint32_t _second_us; // micros() at its start
+	uint32_t _published; // _seconds of hh - YY
+	uint32_t _best_us; // least round trip of this burst
+	uint32_t _delay_us; // round trip of the sample in use
+	uint32_t _t1; // micros() the request went out
+	uint32_t _sent_ms;
+	uint32_t _cookie; // the transmit timestamp of the request, the server sends it back as the originate one
+	uint16_t _age; // seconds since the last good reply
+	uint8_t _sample; // requests of this burst
+	bool _waiting, _synced;
+
+	int8_t _tz_hh, _tz_mm;
+	bool _new_data;
+
+	static uint32_t be32(const uint8_t *b)
+	{
+		return (static_cast<uint32_t>(b[0]) << 24) | (static_cast<uint32_t>(b[1]) << 16) | (static_cast<uint32_t>(b[2]) << 8) | b[3];
+	}
+
+	static void put32(uint8_t *b, const uint32_t v)
+	{
+		b[0] = v >> 24;
+		b[1] = v >> 16;
+		b[2] = v >> 8;
+		b[3] = v;
+	}
+
+	// NTP fraction (1/2^32 s) to us
+	static uint32_t frac_us(const uint32_t f)
+	{
+		return (static_cast<uint64_t>(f) * 1000000UL) >> 32;
+	}
+
+	template <typename UDP, typename HOST>
+	void request(UDP &udp, const HOST &server)
+	{
+		uint8_t packet[NTP_TIME_PACKET];
+		memset(packet, 0, sizeof(packet));
+		packet[0] = 0x23; // LI 0, version 4, mode 3 (client)
+		put32(&packet[40], ++_cookie);
+		udp.beginPacket(server, NTP_TIME_PORT);
+		udp.write(packet, sizeof(packet));
+		_t1 = micros();
+		udp.endPacket();
+		_sent_ms = millis();
+		_waiting = true;
+		++_sample;
+	}
+
+	// One reply, false if it isn't the answer to the last request
+	bool receive(const uint8_t *packet, const uint32_t t4)
+	{
+		const uint8_t li = packet[0] >> 6;
+		const uint8_t mode = packet[0] & 0x07;
+		const uint8_t stratum_rx = packet[1];
+		if ((mode != 4) | (li == 3) | (stratum_rx == 0) | (stratum_rx > 15) | (be32(&packet[24]) != _cookie))
+		{
+			return false; // not a server, not synchronised, a kiss-o'-death or a stale reply
+		}
+		_waiting = false;
+
+		const uint32_t rx_s = be32(&packet[32]), rx_f = be32(&packet[36]);
+		const uint32_t tx_s = be32(&packet[40]), tx_f = be32(&packet[44]);
+		const int32_t server_us = static_cast<int32_t>(tx_s - rx_s) * 1000000L
+			+ static_cast<int32_t>(frac_us(tx_f)) - static_cast<int32_t>(frac_us(rx_f));
+		const int32_t delay = static_cast<int32_t>(t4 - _t1) - server_us;
+		if ((delay < 0) | (delay > static_cast<int32_t>(NTP_TIME_DELAY_MAX_US)) | (static_cast<uint32_t>(delay) >= _best_us))
+		{
+			return true;
+		}
+
+		// UTC at T4, the us past the second
+		const uint32_t utc_us = frac_us(tx_f) + static_cast<uint32_t>(delay) / 2;
+		_seconds = tx_s - NTP_TIME_EPOCH_2000 + utc_us / 1000000UL;
+		_second_us = t4 - utc_us % 1000000UL;
+		_best_us = delay;
+		_delay_us = delay;
+		stratum = stratum_rx;
+		_age = 0;
+		_synced = true;
+		return true;
+	}
+
+	// Freewheel on micros(), new_data() on every new second
+	void tick()
+	{
+		if (!_synced)
+		{
+			return;
+		}
+		const uint32_t now = micros();
+		while (now - _second_us >= 1000000UL)
+		{
+			_second_us += 1000000UL;
+			++_seconds;
+			if (_age < 0xFFFF)
+			{
+				++_age;
+			}
+		}
+		IsValid = _age < NTP_TIME_HOLD_S;
+		if (_seconds != _published)
+		{
+			_published = _seconds;
+			date_from_seconds(_seconds + _tz_hh * 3600L + _tz_mm * 60L, hh, mm, ss, DD, MM, YY);
+			_new_data = true;
+		}
+	}
+public:
+	uint8_t hh, mm, ss, DD, MM, YY;
+	bool IsValid;
+	uint8_t stratum; // of the server, 1 : it has a reference clock, e.g. a GPS
+
+	ntp_time() : _seconds(0), _second_us(0), _published(0), _best_us(0xFFFFFFFFUL), _delay_us(0), _t1(0), _sent_ms(0), _cookie(0),
+		_age(0xFFFF), _sample(0), _waiting(false), _synced(false), _tz_hh(0), _tz_mm(0), _new_data(false),
+		hh(0), mm(0), ss(0), DD(6), MM(1), YY(80), IsValid(false), stratum(0) {}
+
+	template <typename UDP>
+	void begin(UDP &udp)
+	{
+		udp.begin(NTP_TIME_LOCAL_PORT);
+	}
+
+	// Added to UTC, e.g. (10, 30) for ACDT
+	void setTimezone(const int8_t tz_hh, const int8_t tz_mm)
+	{
+		_tz_hh = tz_hh;
+		_tz_mm = tz_mm;
+		_published = _seconds - 1; // worked out again on the next poll()
+	}
+
+	// true once at the start of every second
+	bool new_data()
+	{
+		const bool n = _new_data;
+		_new_data = false;
+		return n;
+	}
+
+	// micros() at the start of ss
+	uint32_t second_us() { return _second_us; }
+
+	// Round trip of the reply in use, the offset is within half of it
+	uint32_t delay_us() { return _delay_us; }
+
+	// Call every loop(), server : a host name or an IPAddress
+	template <typename UDP, typename HOST>
+	void poll(UDP &udp, const HOST &server)
+	{
+		while (_waiting && (udp.parsePacket() > 0))
+		{
+			const uint32_t t4 = micros();
+			uint8_t packet[NTP_TIME_PACKET];
+			if ((udp.read(packet, sizeof(packet)) == NTP_TIME_PACKET) && receive(packet, t4))
+			{
+				break;
+			}
+		}
+		if (_waiting & (millis() - _sent_ms >= NTP_TIME_TIMEOUT_MS))
+		{
+			_waiting = false; // lost, one less sample this burst
+		}
+
+		if (!_waiting)
+		{
+			if (_sample >= NTP_TIME_SAMPLES)
+			{
+				if (millis() - _sent_ms >= NTP_TIME_POLL_S * 1000UL)
+				{
+					_sample = 0;
+					_best_us = 0xFFFFFFFFUL;
+				}
+			}
+			else if ((_sample == 0) | (millis() - _sent_ms >= NTP_TIME_GAP_MS))
+			{
+				request(udp, server);
+			}
+		}
+		tick();
+	}
+};
+
+#endif
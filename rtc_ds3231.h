@@ -0,0 +1,98 @@
+#ifndef RTC_DS3231_H
+#define RTC_DS3231_H
+
+/*
+rtc_ds3231 : minimal DS3231 (or DS3232 / DS1307 compatible) I2C RTC driver, the holdover time source
+
+The time is kept in 24 hour mode as whatever the sketch writes, e.g. the local
+GPS time. read() returns false if the RTC doesn't answer or its oscillator has
+stopped (OSF, the backup battery failed) since the last write(), so a lost time
+is never transmitted.
+
+Pins : A4 (SDA) / A5 (SCL) on the 328p, D2 (SDA) / D3 (SCL) on the 32u4
+Note : write() restarts the RTC's divider chain, the new second starts at the end of the write
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "date_table.h"
+
+#define DS3231_ADDRESS 0x68
+#define DS3231_REG_TIME 0x00
+#define DS3231_REG_STATUS 0x0F
+#define DS3231_OSF 0x80
+
+class rtc_ds3231
+{
+private:
+	static uint8_t from_bcd(const uint8_t v) { return (v >> 4) * 10 + (v & 0x0F); }
+	static uint8_t to_bcd(const uint8_t v) { return ((v / 10) << 4) | (v % 10); }
+
+	static bool select(const uint8_t reg)
+	{
+		Wire.beginTransmission(DS3231_ADDRESS);
+		Wire.write(reg);
+		return (Wire.endTransmission() == 0);
+	}
+public:
+	void begin()
+	{
+		Wire.begin();
+	}
+
+	// Returns false if there is no RTC or its time was lost
+	bool read(uint8_t &hh, uint8_t &mm, uint8_t &ss, uint8_t &DD, uint8_t &MM, uint8_t &YY)
+	{
+		if (!select(DS3231_REG_TIME) | (Wire.requestFrom(DS3231_ADDRESS, 7) != 7))
+		{
+			return false;
+		}
+		ss = from_bcd(Wire.read() & 0x7F);
+		mm = from_bcd(Wire.read() & 0x7F);
+		hh = from_bcd(Wire.read() & 0x3F);
+		Wire.read(); // day of the week
+		DD = from_bcd(Wire.read() & 0x3F);
+		MM = from_bcd(Wire.read() & 0x1F); // bit 7 is the century
+		YY = from_bcd(Wire.read());
+
+		if (!select(DS3231_REG_STATUS) | (Wire.requestFrom(DS3231_ADDRESS, 1) != 1))
+		{
+			return false;
+		}
+		return !(Wire.read() & DS3231_OSF) & (DD > 0) & (DD < 32) & (MM > 0) & (MM < 13) & (hh < 24);
+	}
+
+	// Only the seconds register is read, e.g. to catch the minute boundary
+	bool read_ss(uint8_t &ss)
+	{
+		if (!select(DS3231_REG_TIME) | (Wire.requestFrom(DS3231_ADDRESS, 1) != 1))
+		{
+			return false;
+		}
+		ss = from_bcd(Wire.read() & 0x7F);
+		return true;
+	}
+
+	// Set the time and clear the oscillator stop flag
+	void write(const uint8_t hh, const uint8_t mm, const uint8_t ss, const uint8_t DD, const uint8_t MM, const uint8_t YY)
+	{
+		Wire.beginTransmission(DS3231_ADDRESS);
+		Wire.write(DS3231_REG_TIME);
+		Wire.write(to_bcd(ss));
+		Wire.write(to_bcd(mm));
+		Wire.write(to_bcd(hh)); // 24 hour mode
+		Wire.write((date_to_days(DD, MM, YY) + 6) % 7 + 1); // 1 = Sunday, 01/01/2000 was a Saturday
+		Wire.write(to_bcd(DD));
+		Wire.write(to_bcd(MM));
+		Wire.write(to_bcd(YY));
+		Wire.endTransmission();
+
+		// OSF = 0, the 32kHz output is off
+		Wire.beginTransmission(DS3231_ADDRESS);
+		Wire.write(DS3231_REG_STATUS);
+		Wire.write(0x00);
+		Wire.endTransmission();
+	}
+};
+
+#endif
@@ -0,0 +1,550 @@
+#ifndef TIMECODE_H
+#define TIMECODE_H
+
+/*
+timecode : time code encoders for timecode_tx (wwvb_frame.h)
+
+Every standard sends one symbol per second, made of 100ms slots at full or
+reduced carrier power. An encoder packs the 60 symbols for a minute into a
+small frame buffer and returns the reduced power slots of a second as a
+10 bit mask (bit n = slot n, 0 - 100ms is bit 0).
+
+timecode_encoder<STANDARD> is specialized for each standard, only the one the
+sketch instantiates is compiled in.
+
+--------------+----------+----------------------------------------------
+Standard      | Carrier  | Reduced power
+--------------+----------+----------------------------------------------
+WWVB (USA)    | 60kHz    | 0.2s (0), 0.5s (1), 0.8s (marker) from the start of the second
+DCF77 (DE)    | 77.5kHz  | 0.1s (0), 0.2s (1), none in second 59
+JJY40/60 (JP) | 40/60kHz | the end of the second, 0.2s (0), 0.5s (1), 0.8s (marker)
+MSF (UK)      | 60kHz    | 0.1s then bit A, bit B (0.1s each), 0.5s minute marker
+BPC (CN)      | 68.5kHz  | 0.1s - 0.4s (2 bit symbol), none in seconds 0, 20, 40
+--------------+----------+----------------------------------------------
+
+Note :
+* The carrier is the nearest CPU clock divisor (e.g. 16MHz / 206 = 77.67kHz for DCF77),
+  the same compromise as the 59.925kHz WWVB carrier
+* DCF77 and MSF announce the minute that starts at the next minute marker,
+  WWVB, JJY and BPC send the minute the frame starts in
+* The DST, leap second and DUT1 fields come from the frame flags (TIMECODE_DST_*, see
+  timecode_dst.h) and dut1 (UT1 - UTC in 0.1s), DCF77 and MSF send summer time as local time
+* DCF77 leap second announcements and the JJY call sign minutes are not sent
+* BPC follows the published (unofficial) descriptions : 20s frames, 12 hour clock
+* LOW_Q16 is the high pulse width (Q16 fraction of the carrier period) giving the reduced
+  amplitude of the real transmitter, asin(amplitude) / pi for the tuned coil fundamental
+* TIMECODE_ROUND_ROBIN frames carry the standard in the last byte and dispatch to
+  the encoders above, i.e. all of them are compiled in
+*/
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "date_table.h"
+
+#define TIMECODE_WWVB  0
+#define TIMECODE_DCF77 1
+#define TIMECODE_JJY40 2
+#define TIMECODE_JJY60 3
+#define TIMECODE_MSF   4
+#define TIMECODE_BPC   5
+#define TIMECODE_ROUND_ROBIN 6 // one of the above each minute, see timecode_rotation (wwvb_frame.h)
+
+#define TIMECODE_SLOTS 10 // 100ms slots per second
+
+// Frame flags, the DST ones for the time given to timecode_tx (see timecode_dst.h)
+#define TIMECODE_DST           0x01 // summer time this minute
+#define TIMECODE_DST_NEXT      0x02 // summer time next minute (DCF77 and MSF announce the next minute)
+#define TIMECODE_DST_SOON      0x04 // summer time starts or ends within the hour (DCF77 A1, MSF 53B)
+#define TIMECODE_DST_DAY_START 0x08 // summer time at 00:00 today (WWVB bit 58)
+#define TIMECODE_DST_DAY_END   0x10 // summer time at 24:00 today (WWVB bit 57)
+#define TIMECODE_LEAP_MONTH    0x20 // a leap second is inserted at the end of this month (WWVB LSW, JJY LS1/LS2)
+#define TIMECODE_DST_ALL (TIMECODE_DST | TIMECODE_DST_NEXT | TIMECODE_DST_DAY_START | TIMECODE_DST_DAY_END) // summer time all day
+
+inline void timecode_set_bit(uint8_t *frame, const uint8_t bit)
+{
+	frame[bit >> 3] |= _BV(bit & 0x07);
+}
+
+inline bool timecode_get_bit(const uint8_t *frame, const uint8_t bit)
+{
+	return frame[bit >> 3] & _BV(bit & 0x07);
+}
+
+// Write value over count bits, MSB first from second 'bit'
+inline void timecode_set_bits(uint8_t *frame, uint8_t bit, const uint8_t value, uint8_t count)
+{
+	while (count--)
+	{
+		if (value & _BV(count))
+		{
+			timecode_set_bit(frame, bit);
+		}
+		++bit;
+	}
+}
+
+// Write value over count bits, LSB first from second 'bit'
+inline void timecode_set_bits_lsb(uint8_t *frame, uint8_t bit, uint8_t value, uint8_t count)
+{
+	while (count--)
+	{
+		if (value & 0x01)
+		{
+			timecode_set_bit(frame, bit);
+		}
+		value >>= 1;
+		++bit;
+	}
+}
+
+inline uint8_t timecode_bcd(const uint8_t value)
+{
+	return ((value / 10) << 4) | (value % 10);
+}
+
+// 1 if value has an odd number of 1 bits
+inline uint8_t timecode_parity(uint8_t value)
+{
+	value ^= value >> 4;
+	value ^= value >> 2;
+	value ^= value >> 1;
+	return value & 0x01;
+}
+
+// 0 = Sunday
+inline uint8_t timecode_day_of_week(const uint8_t DD, const uint8_t MM, const uint8_t YY)
+{
+	// 01/01/2000 was a Saturday
+	return (date_to_days(DD, MM, YY) + 6) % 7;
+}
+
+template <uint8_t STANDARD>
+struct timecode_encoder;
+
+/*
+WWVB : NIST Special Publication 432
+*/
+
+// WWVB symbols : the reduced power period is 0.2s (0), 0.5s (1) or 0.8s (marker)
+#define WWVB_ZERO 0
+#define WWVB_ONE 1
+#define WWVB_MARKER 2
+
+// Marker seconds 0,9,19,29,39,49 and 59 as a packed bit mask (bit n = second n), also used by JJY
+const uint8_t wwvb_marker_mask[8] PROGMEM = { 0x01, 0x02, 0x08, 0x20, 0x80, 0x00, 0x02, 0x08 };
+
+const uint16_t wwvb_slots[3] PROGMEM = { 0x0003, 0x001F, 0x00FF };
+
+inline void wwvb_set_bit(uint8_t *frame, const uint8_t bit)
+{
+	timecode_set_bit(frame, bit);
+}
+
+// Write the BCD value over count bits, MSB first from second 'bit'
+// Note : WWVB splits every BCD digit with an unused bit, so each digit is written separately
+inline void wwvb_set_bcd(uint8_t *frame, const uint8_t bit, const uint8_t value, const uint8_t count)
+{
+	timecode_set_bits(frame, bit, value, count);
+}
+
+// Encode the WWVB frame for the minute starting at hh:mm on DD/MM/YY
+// Only the '1' bits are stored, the markers are fixed (wwvb_marker_mask)
+inline void wwvb_encode_frame(uint8_t (&frame)[8], const uint8_t hh, const uint8_t mm,
+	const uint8_t DD, const uint8_t MM, const uint8_t YY, const uint8_t flags = 0, const int8_t dut1 = 0)
+{
+	for (uint8_t i = 0; i < 8; ++i)
+	{
+		frame[i] = 0;
+	}
+
+	const uint16_t doy = date_day_of_year(DD, MM, YY);
+
+	wwvb_set_bcd(frame, 1, mm / 10, 3);        // minutes tens : 40,20,10
+	wwvb_set_bcd(frame, 5, mm % 10, 4);        // minutes units : 8,4,2,1
+	wwvb_set_bcd(frame, 12, hh / 10, 2);       // hours tens : 20,10
+	wwvb_set_bcd(frame, 15, hh % 10, 4);       // hours units : 8,4,2,1
+	wwvb_set_bcd(frame, 22, doy / 100, 2);     // day of year hundreds : 200,100
+	wwvb_set_bcd(frame, 25, (doy / 10) % 10, 4); // day of year tens : 80,40,20,10
+	wwvb_set_bcd(frame, 30, doy % 10, 4);      // day of year units : 8,4,2,1
+	wwvb_set_bcd(frame, 45, YY / 10, 4);       // year tens : 80,40,20,10
+	wwvb_set_bcd(frame, 50, YY % 10, 4);       // year units : 8,4,2,1
+
+	// DUT1 sign (36:38 = 101 -> +, 010 -> -), magnitude : 0.8,0.4,0.2,0.1
+	if (dut1 < 0)
+	{
+		wwvb_set_bit(frame, 37);
+	}
+	else
+	{
+		wwvb_set_bit(frame, 36);
+		wwvb_set_bit(frame, 38);
+	}
+	wwvb_set_bcd(frame, 40, (dut1 < 0) ? -dut1 : dut1, 4);
+
+	if (date_is_leap_year(YY))
+	{
+		wwvb_set_bit(frame, 55);
+	}
+	if (flags & TIMECODE_LEAP_MONTH)
+	{
+		wwvb_set_bit(frame, 56);
+	}
+
+	// 57:58 = 00 standard time, 10 DST starts today, 11 DST in effect, 01 DST ends today
+	if (flags & TIMECODE_DST_DAY_END)
+	{
+		wwvb_set_bit(frame, 57);
+	}
+	if (flags & TIMECODE_DST_DAY_START)
+	{
+		wwvb_set_bit(frame, 58);
+	}
+}
+
+inline uint8_t wwvb_symbol(const uint8_t (&frame)[8], const uint8_t bit)
+{
+	const uint8_t mask = _BV(bit & 0x07);
+	if (pgm_read_byte(&wwvb_marker_mask[bit >> 3]) & mask)
+	{
+		return WWVB_MARKER;
+	}
+	return (frame[bit >> 3] & mask) ? WWVB_ONE : WWVB_ZERO;
+}
+
+template <>
+struct timecode_encoder<TIMECODE_WWVB>
+{
+	static const uint32_t CARRIER_HZ = 60000UL;
+	static const uint16_t LOW_Q16 = 2957; // WWVB -17dB (14.1%)
+	static const uint8_t FRAME_BYTES = 8;
+
+	static void encode(uint8_t (&frame)[FRAME_BYTES], const uint8_t hh, const uint8_t mm,
+		const uint8_t DD, const uint8_t MM, const uint8_t YY, const uint8_t flags, const int8_t dut1)
+	{
+		wwvb_encode_frame(frame, hh, mm, DD, MM, YY, flags, dut1);
+	}
+
+	static uint16_t slots(const uint8_t (&frame)[FRAME_BYTES], const uint8_t ss)
+	{
+		return pgm_read_word(&wwvb_slots[wwvb_symbol(frame, ss)]);
+	}
+};
+
+/*
+DCF77 : PTB, 1 bit per second, BCD fields LSB first with even parity
+*/
+const uint16_t dcf77_slots[3] PROGMEM = { 0x0001, 0x0003, 0x0000 };
+
+template <>
+struct timecode_encoder<TIMECODE_DCF77>
+{
+	static const uint32_t CARRIER_HZ = 77500UL;
+	static const uint16_t LOW_Q16 = 3141; // DCF77 15% (-16.5dB)
+	static const uint8_t FRAME_BYTES = 8;
+
+	static void encode(uint8_t (&frame)[FRAME_BYTES], const uint8_t hh, const uint8_t mm,
+		const uint8_t DD, const uint8_t MM, const uint8_t YY, const uint8_t flags, const int8_t)
+	{
+		for (uint8_t i = 0; i < FRAME_BYTES; ++i)
+		{
+			frame[i] = 0;
+		}
+
+		// the frame announces the next minute, in CEST an hour ahead
+		const bool dst = flags & TIMECODE_DST_NEXT;
+		uint8_t h = hh, m = mm, s = 0, D = DD, M = MM, Y = YY;
+		date_add<uint8_t>(h, m, s, D, M, Y, dst, 1, 0);
+
+		if (flags & TIMECODE_DST_SOON)
+		{
+			timecode_set_bit(frame, 16); // A1 : CET / CEST change at the end of this hour
+		}
+		timecode_set_bit(frame, dst ? 17 : 18); // CEST / CET
+		timecode_set_bit(frame, 20);            // start of the time information
+
+		const uint8_t minute = timecode_bcd(m);
+		const uint8_t hour = timecode_bcd(h);
+		const uint8_t day = timecode_bcd(D);
+		const uint8_t wday = timecode_day_of_week(D, M, Y);
+		const uint8_t dow = (wday == 0) ? 7 : wday; // 1 = Monday, 7 = Sunday
+		const uint8_t month = timecode_bcd(M);
+		const uint8_t year = timecode_bcd(Y);
+
+		timecode_set_bits_lsb(frame, 21, minute, 7);
+		if (timecode_parity(minute)) { timecode_set_bit(frame, 28); }
+		timecode_set_bits_lsb(frame, 29, hour, 6);
+		if (timecode_parity(hour)) { timecode_set_bit(frame, 35); }
+		timecode_set_bits_lsb(frame, 36, day, 6);
+		timecode_set_bits_lsb(frame, 42, dow, 3);
+		timecode_set_bits_lsb(frame, 45, month, 5);
+		timecode_set_bits_lsb(frame, 50, year, 8);
+		if (timecode_parity(day) ^ timecode_parity(dow) ^ timecode_parity(month) ^ timecode_parity(year))
+		{
+			timecode_set_bit(frame, 58);
+		}
+	}
+
+	static uint16_t slots(const uint8_t (&frame)[FRAME_BYTES], const uint8_t ss)
+	{
+		// second 59 has no reduced power period, the next one is the minute marker
+		const uint8_t symbol = (ss == 59) ? 2 : timecode_get_bit(frame, ss);
+		return pgm_read_word(&dcf77_slots[symbol]);
+	}
+};
+
+/*
+JJY : NICT, WWVB like BCD frame, but each second starts at full power
+*/
+const uint16_t jjy_slots[3] PROGMEM = { 0x0300, 0x03E0, 0x03FC };
+
+inline void jjy_encode_frame(uint8_t (&frame)[8], const uint8_t hh, const uint8_t mm,
+	const uint8_t DD, const uint8_t MM, const uint8_t YY, const uint8_t flags = 0)
+{
+	for (uint8_t i = 0; i < 8; ++i)
+	{
+		frame[i] = 0;
+	}
+
+	const uint16_t doy = date_day_of_year(DD, MM, YY);
+	const uint8_t minute = timecode_bcd(mm);
+	const uint8_t hour = timecode_bcd(hh);
+
+	timecode_set_bits(frame, 1, mm / 10, 3);        // minutes tens : 40,20,10
+	timecode_set_bits(frame, 5, mm % 10, 4);        // minutes units : 8,4,2,1
+	timecode_set_bits(frame, 12, hh / 10, 2);       // hours tens : 20,10
+	timecode_set_bits(frame, 15, hh % 10, 4);       // hours units : 8,4,2,1
+	timecode_set_bits(frame, 22, doy / 100, 2);     // day of year hundreds : 200,100
+	timecode_set_bits(frame, 25, (doy / 10) % 10, 4); // day of year tens : 80,40,20,10
+	timecode_set_bits(frame, 30, doy % 10, 4);      // day of year units : 8,4,2,1
+	if (timecode_parity(hour)) { timecode_set_bit(frame, 36); } // PA1
+	if (timecode_parity(minute)) { timecode_set_bit(frame, 37); } // PA2
+	timecode_set_bits(frame, 41, timecode_bcd(YY), 8); // year : 80,40,20,10,8,4,2,1
+	timecode_set_bits(frame, 50, timecode_day_of_week(DD, MM, YY), 3); // 0 = Sunday
+	if (flags & TIMECODE_LEAP_MONTH)
+	{
+		timecode_set_bit(frame, 53); // LS1 : leap second at the end of this month
+		timecode_set_bit(frame, 54); // LS2 : inserted
+	}
+}
+
+template <uint8_t STANDARD>
+struct timecode_jjy
+{
+	static const uint32_t CARRIER_HZ = (STANDARD == TIMECODE_JJY40) ? 40000UL : 60000UL;
+	static const uint16_t LOW_Q16 = 2090; // JJY 10% (-20dB)
+	static const uint8_t FRAME_BYTES = 8;
+
+	static void encode(uint8_t (&frame)[FRAME_BYTES], const uint8_t hh, const uint8_t mm,
+		const uint8_t DD, const uint8_t MM, const uint8_t YY, const uint8_t flags, const int8_t)
+	{
+		jjy_encode_frame(frame, hh, mm, DD, MM, YY, flags);
+	}
+
+	static uint16_t slots(const uint8_t (&frame)[FRAME_BYTES], const uint8_t ss)
+	{
+		// same marker seconds and symbol order as WWVB
+		return pgm_read_word(&jjy_slots[wwvb_symbol(frame, ss)]);
+	}
+};
+
+template <>
+struct timecode_encoder<TIMECODE_JJY40> : timecode_jjy<TIMECODE_JJY40> {};
+
+template <>
+struct timecode_encoder<TIMECODE_JJY60> : timecode_jjy<TIMECODE_JJY60> {};
+
+/*
+MSF : NPL, two bits (A, B) per second, frame[0..7] = A, frame[8..15] = B
+*/
+#define MSF_MARKER 4
+const uint16_t msf_slots[5] PROGMEM = { 0x0001, 0x0003, 0x0005, 0x0007, 0x001F }; // 00, A, B, AB, marker
+
+template <>
+struct timecode_encoder<TIMECODE_MSF>
+{
+	static const uint32_t CARRIER_HZ = 60000UL;
+	static const uint16_t LOW_Q16 = 0; // MSF carrier off
+	static const uint8_t FRAME_BYTES = 16;
+
+	static void encode(uint8_t (&frame)[FRAME_BYTES], const uint8_t hh, const uint8_t mm,
+		const uint8_t DD, const uint8_t MM, const uint8_t YY, const uint8_t flags, const int8_t dut1)
+	{
+		for (uint8_t i = 0; i < FRAME_BYTES; ++i)
+		{
+			frame[i] = 0;
+		}
+		uint8_t *a = frame;
+		uint8_t *b = frame + 8;
+
+		// the frame announces the next minute, in BST an hour ahead
+		const bool dst = flags & TIMECODE_DST_NEXT;
+		uint8_t h = hh, m = mm, s = 0, D = DD, M = MM, Y = YY;
+		date_add<uint8_t>(h, m, s, D, M, Y, dst, 1, 0);
+
+		// DUT1 : one B bit per 0.1s, 1 - 8 positive, 9 - 16 negative
+		const uint8_t first = (dut1 < 0) ? 9 : 1;
+		for (uint8_t i = 0; i < ((dut1 < 0) ? -dut1 : dut1); ++i)
+		{
+			timecode_set_bit(b, first + i);
+		}
+
+		const uint8_t year = timecode_bcd(Y);
+		const uint8_t month = timecode_bcd(M);
+		const uint8_t day = timecode_bcd(D);
+		const uint8_t dow = timecode_day_of_week(D, M, Y);
+		const uint8_t hour = timecode_bcd(h);
+		const uint8_t minute = timecode_bcd(m);
+
+		timecode_set_bits(a, 17, year, 8);
+		timecode_set_bits(a, 25, month, 5);
+		timecode_set_bits(a, 30, day, 6);
+		timecode_set_bits(a, 36, dow, 3);
+		timecode_set_bits(a, 39, hour, 6);
+		timecode_set_bits(a, 45, minute, 7);
+		timecode_set_bits(a, 52, 0x7E, 8); // 52 - 59 : 01111110
+
+		// odd parity
+		if (!timecode_parity(year)) { timecode_set_bit(b, 54); }
+		if (!(timecode_parity(month) ^ timecode_parity(day))) { timecode_set_bit(b, 55); }
+		if (!timecode_parity(dow)) { timecode_set_bit(b, 56); }
+		if (!(timecode_parity(hour) ^ timecode_parity(minute))) { timecode_set_bit(b, 57); }
+		if (flags & TIMECODE_DST_SOON) { timecode_set_bit(b, 53); } // BST change imminent
+		if (dst) { timecode_set_bit(b, 58); } // BST in effect
+	}
+
+	static uint16_t slots(const uint8_t (&frame)[FRAME_BYTES], const uint8_t ss)
+	{
+		const uint8_t symbol = (ss == 0) ? MSF_MARKER : timecode_get_bit(frame, ss) | (timecode_get_bit(frame + 8, ss) << 1);
+		return pgm_read_word(&msf_slots[symbol]);
+	}
+};
+
+/*
+BPC : NTSC, three 20s frames a minute, one 2 bit symbol per second (frame[0..7] = bit 0, frame[8..15] = bit 1)
+*/
+#define BPC_MARKER 4
+const uint16_t bpc_slots[5] PROGMEM = { 0x0001, 0x0003, 0x0007, 0x000F, 0x0000 }; // 0 - 3, frame start
+
+// Write value over count 2 bit symbols, MSB first from second 'ss', returns the parity of value
+inline uint8_t bpc_set_symbols(uint8_t *frame, uint8_t ss, const uint8_t value, uint8_t count)
+{
+	while (count--)
+	{
+		const uint8_t symbol = (value >> (count << 1)) & 0x03;
+		if (symbol & 0x01) { timecode_set_bit(frame, ss); }
+		if (symbol & 0x02) { timecode_set_bit(frame + 8, ss); }
+		++ss;
+	}
+	return timecode_parity(value);
+}
+
+template <>
+struct timecode_encoder<TIMECODE_BPC>
+{
+	static const uint32_t CARRIER_HZ = 68500UL;
+	static const uint16_t LOW_Q16 = 2090; // BPC, unpublished : taken as 10% (-20dB)
+	static const uint8_t FRAME_BYTES = 16;
+
+	static void encode(uint8_t (&frame)[FRAME_BYTES], const uint8_t hh, const uint8_t mm,
+		const uint8_t DD, const uint8_t MM, const uint8_t YY, const uint8_t, const int8_t)
+	{
+		for (uint8_t i = 0; i < FRAME_BYTES; ++i)
+		{
+			frame[i] = 0;
+		}
+		const uint8_t wday = timecode_day_of_week(DD, MM, YY);
+		const uint8_t dow = (wday == 0) ? 7 : wday;
+		for (uint8_t sub = 0; sub < 3; ++sub)
+		{
+			const uint8_t ss = sub * 20; // second 0 : frame start, no reduced power
+			uint8_t parity = bpc_set_symbols(frame, ss + 1, sub, 1); // P1 : 0,20,40s
+			parity ^= bpc_set_symbols(frame, ss + 3, hh % 12, 2);
+			parity ^= bpc_set_symbols(frame, ss + 5, mm, 3);
+			parity ^= bpc_set_symbols(frame, ss + 8, dow, 2);
+			bpc_set_symbols(frame, ss + 10, ((hh >= 12) << 1) | parity, 1); // P3 : PM, parity
+			parity = bpc_set_symbols(frame, ss + 11, DD, 3);
+			parity ^= bpc_set_symbols(frame, ss + 14, MM, 2);
+			parity ^= bpc_set_symbols(frame, ss + 16, YY & 0x3F, 3);
+			bpc_set_symbols(frame, ss + 19, ((YY >> 6) << 1) | parity, 1); // P4 : year bit 6, parity
+		}
+	}
+
+	static uint16_t slots(const uint8_t (&frame)[FRAME_BYTES], const uint8_t ss)
+	{
+		const uint8_t symbol = ((ss % 20) == 0) ? BPC_MARKER : timecode_get_bit(frame, ss) | (timecode_get_bit(frame + 8, ss) << 1);
+		return pgm_read_word(&bpc_slots[symbol]);
+	}
+};
+
+inline uint32_t timecode_carrier_hz(const uint8_t standard)
+{
+	switch (standard)
+	{
+	case TIMECODE_DCF77: return timecode_encoder<TIMECODE_DCF77>::CARRIER_HZ;
+	case TIMECODE_JJY40: return timecode_encoder<TIMECODE_JJY40>::CARRIER_HZ;
+	case TIMECODE_JJY60: return timecode_encoder<TIMECODE_JJY60>::CARRIER_HZ;
+	case TIMECODE_MSF: return timecode_encoder<TIMECODE_MSF>::CARRIER_HZ;
+	case TIMECODE_BPC: return timecode_encoder<TIMECODE_BPC>::CARRIER_HZ;
+	default: return timecode_encoder<TIMECODE_WWVB>::CARRIER_HZ;
+	}
+}
+
+inline uint16_t timecode_low_q16(const uint8_t standard)
+{
+	switch (standard)
+	{
+	case TIMECODE_DCF77: return timecode_encoder<TIMECODE_DCF77>::LOW_Q16;
+	case TIMECODE_JJY40: return timecode_encoder<TIMECODE_JJY40>::LOW_Q16;
+	case TIMECODE_JJY60: return timecode_encoder<TIMECODE_JJY60>::LOW_Q16;
+	case TIMECODE_MSF: return timecode_encoder<TIMECODE_MSF>::LOW_Q16;
+	case TIMECODE_BPC: return timecode_encoder<TIMECODE_BPC>::LOW_Q16;
+	default: return timecode_encoder<TIMECODE_WWVB>::LOW_Q16;
+	}
+}
+
+/*
+Round robin : frame[16] is the standard of the frame, set before encode()
+*/
+template <>
+struct timecode_encoder<TIMECODE_ROUND_ROBIN>
+{
+	static const uint32_t CARRIER_HZ = 60000UL; // until a rotation is set
+	static const uint16_t LOW_Q16 = 2957; // WWVB, see timecode_low_q16()
+	static const uint8_t FRAME_BYTES = 17;
+
+	typedef uint8_t frame8_t[8];
+	typedef uint8_t frame16_t[16];
+
+	static void encode(uint8_t (&frame)[FRAME_BYTES], const uint8_t hh, const uint8_t mm,
+		const uint8_t DD, const uint8_t MM, const uint8_t YY, const uint8_t flags, const int8_t dut1)
+	{
+		frame8_t &f8 = *reinterpret_cast<frame8_t *>(frame);
+		frame16_t &f16 = *reinterpret_cast<frame16_t *>(frame);
+		switch (frame[16])
+		{
+		case TIMECODE_DCF77: timecode_encoder<TIMECODE_DCF77>::encode(f8, hh, mm, DD, MM, YY, flags, dut1); break;
+		case TIMECODE_JJY40: timecode_encoder<TIMECODE_JJY40>::encode(f8, hh, mm, DD, MM, YY, flags, dut1); break;
+		case TIMECODE_JJY60: timecode_encoder<TIMECODE_JJY60>::encode(f8, hh, mm, DD, MM, YY, flags, dut1); break;
+		case TIMECODE_MSF: timecode_encoder<TIMECODE_MSF>::encode(f16, hh, mm, DD, MM, YY, flags, dut1); break;
+		case TIMECODE_BPC: timecode_encoder<TIMECODE_BPC>::encode(f16, hh, mm, DD, MM, YY, flags, dut1); break;
+		default: timecode_encoder<TIMECODE_WWVB>::encode(f8, hh, mm, DD, MM, YY, flags, dut1); break;
+		}
+	}
+
+	static uint16_t slots(const uint8_t (&frame)[FRAME_BYTES], const uint8_t ss)
+	{
+		const frame8_t &f8 = *reinterpret_cast<const frame8_t *>(frame);
+		const frame16_t &f16 = *reinterpret_cast<const frame16_t *>(frame);
+		switch (frame[16])
+		{
+		case TIMECODE_DCF77: return timecode_encoder<TIMECODE_DCF77>::slots(f8, ss);
+		case TIMECODE_JJY40: return timecode_encoder<TIMECODE_JJY40>::slots(f8, ss);
+		case TIMECODE_JJY60: return timecode_encoder<TIMECODE_JJY60>::slots(f8, ss);
+		case TIMECODE_MSF: return timecode_encoder<TIMECODE_MSF>::slots(f16, ss);
+		case TIMECODE_BPC: return timecode_encoder<TIMECODE_BPC>::slots(f16, ss);
+		default: return timecode_encoder<TIMECODE_WWVB>::slots(f8, ss);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef TIMECODE_DST_H
+#define TIMECODE_DST_H
+
+/*
+timecode_dst : daylight saving time rules for the frame DST bits (timecode_tx::set_dst_rule())
+
+A rule is the Sunday summer time starts and ends on, as the local standard time
+of the change, i.e. the time the sketch gives to set_time() (the GPS time with
+the fixed local timezone). timecode_dst_flags() returns the TIMECODE_DST_* flags
+of timecode.h for a minute, timecode_tx evaluates them for every frame.
+
+-----------------+--------------------------------+--------------------------------
+Rule             | Starts (standard time)         | Ends (standard time)
+-----------------+--------------------------------+--------------------------------
+TIMECODE_DST_US  | 2nd Sunday in March 02:00      | 1st Sunday in November 01:00
+TIMECODE_DST_EU  | last Sunday in March 02:00     | last Sunday in October 02:00
+TIMECODE_DST_AU  | 1st Sunday in October 02:00    | 1st Sunday in April 02:00
+-----------------+--------------------------------+--------------------------------
+
+Note :
+* EU changes at 01:00 UTC, the table is for CET (UTC+1), use 01:00 for GMT/WET and 03:00 for EET
+* AU is NSW, VIC, ACT, TAS and SA, the states without summer time use TIMECODE_DST_NONE
+* The day of the WWVB DST bits is the day of the given time, not the UTC day
+*/
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "timecode.h"
+
+#define TIMECODE_DST_NONE 0 // the dst argument of set_time() / sync_time() is sent
+#define TIMECODE_DST_US 1
+#define TIMECODE_DST_EU 2
+#define TIMECODE_DST_AU 3
+
+#define TIMECODE_DST_LAST 5 // week : the last Sunday of the month
+
+struct timecode_dst_rule
+{
+	uint8_t start_MM, start_week, start_hh; // week 1 - 4, or TIMECODE_DST_LAST
+	uint8_t end_MM, end_week, end_hh;
+};
+
+const timecode_dst_rule timecode_dst_rules[3] PROGMEM = {
+	{ 3, 2, 2, 11, 1, 1 },                                // US
+	{ 3, TIMECODE_DST_LAST, 2, 10, TIMECODE_DST_LAST, 2 }, // EU (CET)
+	{ 10, 1, 2, 4, 1, 2 }                                 // AU
+	};
+
+// Day of the month of the week'th Sunday of MM/YY
+inline uint8_t timecode_dst_sunday(const uint8_t week, const uint8_t MM, const uint8_t YY)
+{
+	uint8_t DD = 1 + (7 - timecode_day_of_week(1, MM, YY)) % 7 + 7 * (week - 1);
+	if (DD > date_days_in_month(MM, YY))
+	{
+		DD -= 7;
+	}
+	return DD;
+}
+
+// Minutes since the start of the year
+inline uint32_t timecode_dst_minute(const uint8_t hh, const uint8_t mm, const uint8_t DD, const uint8_t MM, const uint8_t YY)
+{
+	return (date_day_of_year(DD, MM, YY) - 1) * static_cast<uint32_t>(DATE_MINUTES_PER_DAY) + hh * 60U + mm;
+}
+
+// TIMECODE_DST_* flags for the minute hh:mm on DD/MM/YY (standard time) under rule
+inline uint8_t timecode_dst_flags(const uint8_t rule, const uint8_t hh, const uint8_t mm, const uint8_t DD, const uint8_t MM, const uint8_t YY)
+{
+	if ((rule == TIMECODE_DST_NONE) | (rule > TIMECODE_DST_AU))
+	{
+		return 0;
+	}
+	const timecode_dst_rule *r = &timecode_dst_rules[rule - 1];
+	const uint8_t start_MM = pgm_read_byte(&r->start_MM);
+	const uint8_t end_MM = pgm_read_byte(&r->end_MM);
+	const uint32_t start = timecode_dst_minute(pgm_read_byte(&r->start_hh), 0,
+		timecode_dst_sunday(pgm_read_byte(&r->start_week), start_MM, YY), start_MM, YY);
+	const uint32_t end = timecode_dst_minute(pgm_read_byte(&r->end_hh), 0,
+		timecode_dst_sunday(pgm_read_byte(&r->end_week), end_MM, YY), end_MM, YY);
+
+	const uint32_t year = (date_is_leap_year(YY) ? 366UL : 365UL) * DATE_MINUTES_PER_DAY;
+	const uint32_t minute = timecode_dst_minute(hh, mm, DD, MM, YY);
+	const uint32_t day = minute - (hh * 60U + mm);
+	// the minutes checked, none of the rules changes over the new year
+	const uint32_t at[5] = { minute, minute + 1, minute + 60, day, day + DATE_MINUTES_PER_DAY - 1 };
+
+	uint8_t dst = 0;
+	for (uint8_t i = 0; i < 5; ++i)
+	{
+		const uint32_t t = (at[i] < year) ? at[i] : year - 1;
+		const bool in_effect = (start < end) ? (t >= start) & (t < end) : (t >= start) | (t < end);
+		dst |= in_effect << i;
+	}
+
+	uint8_t flags = 0;
+	if (dst & 0x01) { flags |= TIMECODE_DST; }
+	if (dst & 0x02) { flags |= TIMECODE_DST_NEXT; }
+	if (((dst >> 2) ^ dst) & 0x01) { flags |= TIMECODE_DST_SOON; }
+	if (dst & 0x08) { flags |= TIMECODE_DST_DAY_START; }
+	if (dst & 0x10) { flags |= TIMECODE_DST_DAY_END; }
+	return flags;
+}
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef TINY_UART_H
+#define TINY_UART_H
+
+/*
+tiny_uart : ATtiny85 GPS receiver, the start bit edge on INT0 and the bits timed on Timer0 compare B
+
+The ATtiny85 has no USART and Timer1 makes the carrier. SoftwareSerial reads a whole
+byte with interrupts off (~1ms at 9600 baud, 60 lost carrier cycles), here every bit
+is one short interrupt : the falling edge of the start bit (INT0) sets a Timer0 compare B
+match on the middle of the first data bit, and every match samples a bit and moves the
+compare on by a bit time. The bit time is kept to 1/256 of a Timer0 tick, so the timing
+doesn't build up an error over the byte. Timer0 keeps running for millis(), its prescaler
+is left as the core set it and read back in begin().
+
+The cores run Timer0 in fast PWM, where OCR0B is double buffered and only loads at TOP,
+i.e. once an overflow (256 ticks, ~2ms at 8MHz / 64), much later than the next bit.
+begin() puts Timer0 in normal mode, it still overflows every 256 ticks so millis() is
+the same, but the compare outputs are off : no analogWrite() on PB0 (OC0A) or PB1 (OC0B).
+
+Usage :
+	tiny_uart ttl;
+	ISR(INT0_vect)
+	{
+		ttl.edge_interrupt();
+	}
+	ISR(TIMER0_COMPB_vect)
+	{
+		ttl.bit_interrupt();
+	}
+
+Pins : GPS Tx => PB2 (INT0, pin 7), GPS Rx <= PB1 (pin 6, write() is polled, only for nmea_configure())
+Note : USE_OC1A (PB1) and analogWrite() on PB0 / PB1 (Timer0) are not available
+Note : F_CPU / TINY_UART_PRESCALER / TINY_UART_BAUD has to be 8 - 255 timer ticks a bit, e.g. 8MHz / 64 at 9600 baud
+       is 13, checked at compile time, set TINY_UART_PRESCALER if the core runs Timer0 on another prescaler
+*/
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+
+#if !(defined(__AVR_ATtiny25__) | defined(__AVR_ATtiny45__) | defined(__AVR_ATtiny85__))
+#error tiny_uart.h : ATtiny25/45/85 only, use gps_uart.h on the ATmega
+#endif
+
+#ifndef TINY_UART_BAUD
+#define TINY_UART_BAUD 9600
+#endif
+
+#ifndef TINY_UART_PRESCALER
+#define TINY_UART_PRESCALER 64 // the Timer0 prescaler the core sets for millis() (ATTinyCore and damellis at 8 / 16MHz)
+#endif
+
+#define TINY_UART_TICKS (F_CPU / TINY_UART_PRESCALER / TINY_UART_BAUD) // Timer0 ticks a bit
+
+static_assert((TINY_UART_TICKS >= 8) & (TINY_UART_TICKS <= 255), "tiny_uart.h : F_CPU / TINY_UART_PRESCALER / TINY_UART_BAUD has to be 8 - 255 Timer0 ticks a bit");
+
+// Ring buffer size, must be a power of 2
+#ifndef TINY_UART_BUFFER
+#define TINY_UART_BUFFER 16
+#endif
+
+class tiny_uart : public Stream
+{
+private:
+	uint8_t _buffer[TINY_UART_BUFFER];
+	volatile uint8_t _head;
+	volatile uint8_t _tail;
+	volatile uint8_t _overflow;
+
+	uint16_t _bit_q8; // Timer0 ticks per bit, Q8
+	uint16_t _at_q8; // the next compare match, Q8 of the 8 bit count
+	uint8_t _bits; // bits left in this byte, including the stop bit
+	uint8_t _rx;
+	uint16_t _bit_us; // polled transmit
+public:
+	tiny_uart() : _head(0), _tail(0), _overflow(0), _bit_q8(0), _at_q8(0), _bits(0), _rx(0), _bit_us(0) {}
+
+	// 8N1 at TINY_UART_BAUD
+	void begin()
+	{
+		// normal mode, OCR0B is written straight through (the PWM modes load it at TOP), TOP is still 0xFF
+		TCCR0A &= ~(_BV(COM0A1) | _BV(COM0A0) | _BV(COM0B1) | _BV(COM0B0) | _BV(WGM01) | _BV(WGM00));
+		TCCR0B &= ~_BV(WGM02);
+
+		// Timer0 clock select 1 - 5 : F_CPU / 1, 8, 64, 256 or 1024
+		const uint8_t cs = TCCR0B & (_BV(CS02) | _BV(CS01) | _BV(CS00));
+		const uint8_t shift = (cs == 2) ? 3 : (cs == 3) ? 6 : (cs == 4) ? 8 : (cs == 5) ? 10 : 0;
+		const uint32_t cycles_q8 = (F_CPU / TINY_UART_BAUD) * 256UL + (F_CPU % TINY_UART_BAUD) * 256UL / TINY_UART_BAUD; // CPU cycles a bit
+		_bit_q8 = cycles_q8 >> shift;
+		_bit_us = 1000000UL / TINY_UART_BAUD;
+
+		DDRB |= _BV(PB1);
+		PORTB |= _BV(PB1); // Tx idles high
+		DDRB &= ~_BV(PB2);
+		PORTB |= _BV(PB2); // pull up, an unplugged GPS reads as idle
+
+		MCUCR = (MCUCR & ~(_BV(ISC01) | _BV(ISC00))) | _BV(ISC01); // falling edge
+		GIFR = _BV(INTF0);
+		GIMSK |= _BV(INT0);
+	}
+
+	void end()
+	{
+		cli();
+		GIMSK &= ~_BV(INT0);
+		TIMSK &= ~_BV(OCIE0B);
+		_bits = 0;
+		_head = _tail;
+		sei();
+	}
+
+	// Bytes dropped because loop() did not keep up
+	uint8_t overflow() { return _overflow; }
+
+	virtual int available()
+	{
+		return static_cast<uint8_t>(_head - _tail) & (TINY_UART_BUFFER - 1);
+	}
+
+	virtual int peek()
+	{
+		if (_head == _tail)
+		{
+			return -1;
+		}
+		return _buffer[_tail];
+	}
+
+	virtual int read()
+	{
+		if (_head == _tail)
+		{
+			return -1;
+		}
+		const uint8_t c = _buffer[_tail];
+		_tail = (_tail + 1) & (TINY_UART_BUFFER - 1);
+		return c;
+	}
+
+	// Polled transmit with interrupts off, only used to send the GPS module its configuration at setup()
+	virtual size_t write(uint8_t c)
+	{
+		const uint8_t sreg = SREG;
+		cli();
+		PORTB &= ~_BV(PB1); // start bit
+		delayMicroseconds(_bit_us);
+		for (uint8_t i = 0; i < 8; ++i)
+		{
+			if (c & 0x01)
+			{
+				PORTB |= _BV(PB1);
+			}
+			else
+			{
+				PORTB &= ~_BV(PB1);
+			}
+			c >>= 1;
+			delayMicroseconds(_bit_us);
+		}
+		PORTB |= _BV(PB1); // stop bit
+		SREG = sreg;
+		delayMicroseconds(_bit_us);
+		return 1;
+	}
+
+	virtual void flush() {}
+
+	using Print::write;
+
+	// Call from ISR(INT0_vect), the falling edge of a start bit
+	inline void edge_interrupt()
+	{
+		const uint8_t t = TCNT0;
+		GIMSK &= ~_BV(INT0); // the data bits are sampled, not edge triggered
+		_at_q8 = (static_cast<uint16_t>(t) << 8) + _bit_q8 + (_bit_q8 >> 1); // middle of data bit 0
+		OCR0B = _at_q8 >> 8;
+		TIFR = _BV(OCF0B);
+		TIMSK |= _BV(OCIE0B);
+		_bits = 9;
+		_rx = 0;
+	}
+
+	// Call from ISR(TIMER0_COMPB_vect), the middle of a data or the stop bit
+	inline void bit_interrupt()
+	{
+		const bool high = PINB & _BV(PB2);
+		if (--_bits)
+		{
+			_rx = (_rx >> 1) | (high ? 0x80 : 0x00);
+			_at_q8 += _bit_q8;
+			OCR0B = _at_q8 >> 8;
+			return;
+		}
+
+		// stop bit, a low one is a framing error and the byte is dropped
+		TIMSK &= ~_BV(OCIE0B);
+		if (high)
+		{
+			const uint8_t next = (_head + 1) & (TINY_UART_BUFFER - 1);
+			if (next != _tail)
+			{
+				_buffer[_head] = _rx;
+				_head = next;
+			}
+			else
+			{
+				++_overflow;
+			}
+		}
+		GIFR = _BV(INTF0);
+		GIMSK |= _BV(INT0);
+	}
+};
+
+#endif
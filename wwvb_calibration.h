@@ -0,0 +1,193 @@
+#ifndef WWVB_CALIBRATION_H
+#define WWVB_CALIBRATION_H
+
+/*
+wwvb_calibration : the learned resonator trim (wwvb_frame.h calibrate_q16()) kept in EEPROM
+
+Every board's resonator is different, so a fresh boot with calibrate(0) runs
+off by up to a few hundred ppm until the GPS has disciplined it again. This
+keeps the trim once it has settled, so the next boot starts already trimmed.
+
+Usage :
+	wwvb_calibration calibration; // EEPROM address 0
+	setup() : if (calibration.load(trim_q16)) wwvb_tx.calibrate_q16(trim_q16);
+	loop()  : once a minute (wwvb_tx.update() returns true)
+		calibration.update(wwvb_tx.trim_q16(), wwvb_tx.pps_good_seconds() >= 50);
+
+update() only counts minutes that were disciplined (e.g. by at least 50 good PPS
+edges). A trim that stays within WWVB_CAL_STABLE_Q16 for WWVB_CAL_SETTLE_MINUTES is
+saved if it moved by more than WWVB_CAL_SAVE_Q16 from the stored one, or to refresh
+its metadata every WWVB_CAL_REFRESH_MINUTES. Only the changed bytes are written
+(eeprom_update_block), so the EEPROM sees at most a few writes a day.
+
+The record also keeps the disciplined minutes behind the value (age), the number of
+saves and the chip temperature at the last save (internal sensor, +-10C, ATmega328p
+and ATtiny85 only, WWVB_CAL_NO_TEMPERATURE elsewhere).
+*/
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <avr/eeprom.h>
+#include <avr/power.h>
+#include <util/crc16.h>
+
+#ifndef WWVB_CAL_ADDRESS
+#define WWVB_CAL_ADDRESS 0
+#endif
+
+#define WWVB_CAL_MAGIC 0xCA
+#define WWVB_CAL_NO_TEMPERATURE -128
+
+#define WWVB_CAL_STABLE_Q16 (65536L / 16) // 1/16 cycle, ~1ppm @ 60kHz
+#define WWVB_CAL_SAVE_Q16 (65536L / 4)
+#define WWVB_CAL_SETTLE_MINUTES 10
+#define WWVB_CAL_REFRESH_MINUTES 1440
+
+struct wwvb_calibration_record
+{
+	uint8_t magic;
+	int32_t trim_q16;
+	uint16_t minutes; // disciplined minutes behind the value
+	uint16_t saves;
+	int8_t temperature; // C at the last save
+	uint8_t crc;
+};
+
+// Chip temperature in C from the internal sensor (uncalibrated)
+inline int8_t wwvb_temperature()
+{
+#if defined(__AVR_ATmega328P__) | defined(__AVR_ATmega168__) | defined(__AVR_ATtiny85__)
+	const uint8_t adcsra = ADCSRA;
+	power_adc_enable();
+#if defined(__AVR_ATtiny85__)
+	ADMUX = _BV(REFS1) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1) | _BV(MUX0); // ADC4, 1.1V
+#else
+	ADMUX = _BV(REFS1) | _BV(REFS0) | _BV(MUX3); // ADC8, 1.1V
+#endif
+	ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+	// the first conversion after switching the reference is discarded
+	uint16_t adc = 0;
+	for (uint8_t i = 0; i < 2; ++i)
+	{
+		ADCSRA |= _BV(ADSC);
+		while (ADCSRA & _BV(ADSC)) {}
+		adc = ADC;
+	}
+	ADCSRA = adcsra;
+	if (!(adcsra & _BV(ADEN)))
+	{
+		power_adc_disable();
+	}
+#if defined(__AVR_ATtiny85__)
+	return static_cast<int16_t>(adc) - 275; // ~1 LSB/C, 300 @ 25C
+#else
+	return (static_cast<int32_t>(adc) * 100 - 32431) / 122; // (ADC - 324.31) / 1.22
+#endif
+#else
+	return WWVB_CAL_NO_TEMPERATURE;
+#endif
+}
+
+class wwvb_calibration
+{
+private:
+	wwvb_calibration_record _record;
+	bool _valid;
+	const uint16_t _address;
+
+	int32_t _last;
+	uint8_t _stable; // minutes _last stayed within WWVB_CAL_STABLE_Q16
+	uint16_t _minutes; // disciplined minutes since the last save
+
+	static uint8_t crc(const wwvb_calibration_record &r)
+	{
+		const uint8_t *p = reinterpret_cast<const uint8_t *>(&r);
+		uint8_t c = 0;
+		for (uint8_t i = 0; i < offsetof(wwvb_calibration_record, crc); ++i)
+		{
+			c = _crc_ibutton_update(c, p[i]);
+		}
+		return c;
+	}
+
+	static int32_t difference(const int32_t a, const int32_t b)
+	{
+		return (a > b) ? a - b : b - a;
+	}
+public:
+	wwvb_calibration(const uint16_t address = WWVB_CAL_ADDRESS) : _valid(false), _address(address),
+		_last(0), _stable(0), _minutes(0)
+	{
+		_record.minutes = 0;
+		_record.saves = 0;
+	}
+
+	// Read the stored trim, returns false if there is none (blank or corrupt EEPROM)
+	bool load(int32_t &trim_q16)
+	{
+		eeprom_read_block(&_record, reinterpret_cast<const void *>(_address), sizeof(_record));
+		_valid = (_record.magic == WWVB_CAL_MAGIC) & (_record.crc == crc(_record));
+		if (!_valid)
+		{
+			_record.minutes = 0;
+			_record.saves = 0;
+			return false;
+		}
+		trim_q16 = _last = _record.trim_q16;
+		return true;
+	}
+
+	void save(const int32_t trim_q16)
+	{
+		const uint32_t minutes = static_cast<uint32_t>(_record.minutes) + _minutes;
+		_record.magic = WWVB_CAL_MAGIC;
+		_record.trim_q16 = trim_q16;
+		_record.minutes = (minutes > 0xFFFF) ? 0xFFFF : minutes;
+		++_record.saves;
+		_record.temperature = wwvb_temperature();
+		_record.crc = crc(_record);
+		eeprom_update_block(&_record, reinterpret_cast<void *>(_address), sizeof(_record));
+		_valid = true;
+		_minutes = 0;
+	}
+
+	// Call once a minute, disciplined : the trim was tracking a reference this minute
+	// Returns true if the trim was saved
+	bool update(const int32_t trim_q16, const bool disciplined)
+	{
+		if (!disciplined)
+		{
+			_stable = 0;
+			return false;
+		}
+		++_minutes;
+		if (difference(trim_q16, _last) <= WWVB_CAL_STABLE_Q16)
+		{
+			if (_stable < 0xFF)
+			{
+				++_stable;
+			}
+		}
+		else
+		{
+			_stable = 0;
+		}
+		_last = trim_q16;
+
+		if (_stable < WWVB_CAL_SETTLE_MINUTES)
+		{
+			return false;
+		}
+		if (!_valid | (difference(trim_q16, _record.trim_q16) > WWVB_CAL_SAVE_Q16) | (_minutes >= WWVB_CAL_REFRESH_MINUTES))
+		{
+			save(trim_q16);
+			return true;
+		}
+		return false;
+	}
+
+	bool valid() { return _valid; }
+	const wwvb_calibration_record &record() { return _record; }
+};
+
+#endif
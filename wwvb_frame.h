@@ -0,0 +1,1846 @@
+#ifndef WWVB_FRAME_H
+#define WWVB_FRAME_H
+
+/*
+wwvb_frame : time code transmitter driven by a precomputed frame buffer
+
+timecode_tx<STANDARD> sends WWVB, DCF77, JJY40/60, MSF or BPC (see timecode.h),
+wwvb_frame is timecode_tx<TIMECODE_WWVB>.
+
+timecode_tx<TIMECODE_ROUND_ROBIN> time slices the transmitter across the standards of a
+timecode_rotation (set_rotation()), each with its own timezone. The ISR switches the
+carrier (Timer1 TOP) and the slot timing on the minute boundary.
+
+The frame for a minute is encoded in the foreground (set_time() / update())
+into a packed buffer. The Timer1 overflow ISR only counts carrier cycles,
+steps through the 100ms slots of the second and reloads the PWM compare register.
+
+Call update() from loop() at least once a minute, it encodes the next minute
+into the back buffer which the ISR swaps in at the minute boundary.
+
+Optional GPS PPS discipline : call pps_interrupt() from the PPS pin interrupt
+(attachInterrupt on INT0/INT1). Every PPS edge measures where the transmitter is
+within its second, shifts the last slot of the second to line the second up with
+the edge, and integrates the residual into the carrier cycles per second.
+
+The second length is carrier cycles plus a 16 bit fraction (Q16) : the fractional
+cycles are added into a phase accumulator once per second, its carry lengthens the
+last slot by a cycle. F_CPU / TOP that is not a whole number of cycles (16MHz / 267 =
+59925.09) and the calibrate_q16() correction are both kept to 1/65536 cycle (< 0.001ppm).
+
+wwvb_tx.clock (epoch_clock.h) is the time given to set_time() / sync_time(), e.g. the
+local GPS time, ticked by the ISR at the start of every transmitted second and
+freewheeling on millis() while the transmitter is stopped. Read it with
+clock.get() for the display instead of converting the frame time back.
+
+Optional DST rule (set_dst_rule(), see timecode_dst.h) : the DST flags of every frame are
+worked out from the rule for the given time (the local standard time, e.g. the GPS time
+with a fixed timezone) when the minute is encoded, so the start / end of summer time and
+the DCF77 / MSF announcements are sent on the right minute without a resync. Otherwise the
+dst argument of set_time() / sync_time() is sent as summer time all day.
+set_dut1() and set_leap_second() fill in the DUT1 and leap second warning fields
+(IERS Bulletins C and D, NMEA carries neither).
+
+The Timer1 TOP, duty values and carrier cycles per 100ms slot are worked out at
+compile time from the timer clock and the carrier (timecode_timer<>), a static_assert
+stops the build if the timer can not make the carrier at all (TIMECODE_CARRIER_PPM).
+A receiver's crystal filter only passes a few tens of Hz either side of the carrier
+(TIMECODE_CARRIER_HZ_RX, +-25Hz : 417ppm WWVB, 323ppm DCF77, 365ppm BPC, 625ppm JJY40),
+a carrier outside it stops the build too. TIMECODE_CARRIER_STRICT 0 lets it build, it is
+then only picked up with the receiver next to the loop, if at all.
+
+WWVB_DITHER 1 (the default) : the clocks per carrier cycle are rarely a whole number
+(16MHz / 60kHz = 266.67), so the ISR sets TOP for each cycle from a Q16 phase accumulator,
+that share of the cycles is a clock longer (266, 267, 267, ...) and the average is the
+carrier to 1/65536 clock per cycle. The phase jitter is one timer clock (62.5ns at 16MHz).
+WWVB_DITHER 0 keeps TOP fixed at the nearest whole period, a few less ISR cycles, and the
+carrier is off by (TIMECODE_CARRIER_STRICT 0 needed for all but the plain rows) :
+
+WWVB_DITHER 0                 | JJY40       | WWVB / JJY60 / MSF | BPC          | DCF77
+16MHz Timer1                  | 0Hz         | -75Hz   near       | -124Hz  no   | +170Hz  no
+16MHz Timer2, 8MHz Timer1,    | 0Hz         | +150Hz  no         | -124Hz  no   | +170Hz  no
+ATtiny 8/16MHz (PLL 64MHz)    |             |                    |              |
+20MHz Timer1                  | 0Hz         | +60Hz   near       | -7Hz         | +19Hz
+ATtiny 16.5MHz (PLL 66MHz)    | +49Hz near  | -217Hz  no         | -35Hz   near | -35Hz   near
+ESP32 LEDC (never dithered)   | 0Hz         | +15Hz              | +17Hz        | +19Hz
+(near : a few tens of Hz outside, may lock with the receiver on the loop, no : builds but is
+not received, the calibrate_q16() / PPS trim is far too small to pull either in)
+#define WWVB_PWM_LOW before including this file to set the reduced power level,
+WWVB_PWM_LOW_TRUE is the amplitude of the real transmitter (e.g. WWVB -17dB, see LOW_Q16
+in timecode.h) rounded to the nearest timer clock of the high pulse width.
+
+ATtiny85 : #define WWVB_ATTINY_PLL 1 clocks Timer1 from the 64MHz PLL (PCK, needs 4.5V+
+for 64MHz), e.g. an 8MHz internal RC build gets 8x the duty resolution. The PLL runs from
+the internal RC oscillator, i.e. F_CPU is the RC (8MHz) or the PLL / 4 (16MHz, 16.5MHz).
+
+Optional ISR instrumentation : #define WWVB_ISR_STATS 1 before including this file
+(ATmega only). Every overflow records the entry latency (TCNT1 on entry, CPU cycles
+since the overflow, including the ISR prologue) and the duration (TCNT1 on exit - entry)
+into min/max values and a latency histogram, see print_stats(). TCNT1 wraps every carrier
+cycle, an ISR held off longer (e.g. a SoftwareSerial byte, ~60 cycles) shows as a small
+latency. Lost overflows are counted apart : every 256 overflows the time since (micros(),
+Timer0) is compared with 256 carrier cycles, the whole cycles left over had no interrupt.
+Note : micros() itself falls behind with the interrupts off for over 1ms
+
+Optional loopback self check : #define WWVB_LOOPBACK 1 before including this file.
+At the start of every second and on every reduced power edge the ISR timestamps what it
+emitted (micros(), Timer0, independent of the carrier count), into a ring of the last 60
+seconds (4 bytes each). update() decodes the ring with the pulse width rules of a clock :
+the reduced power time has to be within WWVB_LOOPBACK_TOLERANCE_MS of the 100ms steps of
+the intended symbol and the second within it of 1s. Late overflow interrupts (lost carrier
+cycles) stretch the slots they hit, see get_loopback() / print_loopback() for the bad
+seconds per minute. Note : PPS phase steps and restarts are counted as bad seconds too.
+
+Optional resync drift telemetry : #define WWVB_DRIFT 1 before including this file.
+The ISR timestamps the start of every transmitted second (micros()). drift() takes a
+reference second, e.g. the GPS time of the 0s sentence and the micros() its NMEA burst
+started (nmea_filter::burst_us()), extrapolates the transmitted seconds to it at the
+trimmed rate (also across a stop()) and returns how late the transmitter second starts.
+The change of that offset over WWVB_DRIFT_SPAN seconds or more is the rate error of the
+trim, the NMEA latency cancels out. With set_drift_auto(true) half of a rate error over
+WWVB_DRIFT_DEADBAND_PPB is taken out of the trim, closing the loop without a PPS (the PPS
+discipline does it per second, leave it off with pps_interrupt()). The resolution is the
+NMEA burst timestamp, ~1ms read by loop() is ~2ppm over 10 minutes. See get_drift().
+
+Optional second coil (ATmega) : #define both USE_OC1A and USE_OC1B before including this
+file. OC1B is written by the same ISR from the same frame and Timer1 TOP, set_output_b()
+sets its phase to OC1A and its own reduced power level. WWVB_PHASE_180 inverts OC1B, its
+pulse ends at TOP instead of starting at BOTTOM : at the high level (50%) it is the
+complement of OC1A, i.e. the two legs of an H-bridge (twice the coil voltage), and at a
+reduced level both legs are low between the pulses so the coil sees no DC. Fast PWM has
+no finer phase, a coil that wants another phase needs another timer.
+
+Carrier timer backend : timecode_tx<STANDARD, wwvb_timer2> makes the carrier with Timer2
+(CTC toggling OC2A, D11, ATmega328p) instead of Timer1, call interrupt_routine() from
+ISR(TIMER2_COMPA_vect). Timer1 is left free, e.g. to input capture the GPS PPS. The frame,
+PPS and drift logic is the same, it counts two interrupts per carrier cycle, so the trim
+(calibrate(), pps_error()) is in half cycles. See wwvb_timer1 / wwvb_timer2.
+
+ESP32 : the default backend is wwvb_ledc (wwvb_ledc.h), the LEDC makes the carrier and an
+esp_timer ticks the ISR every 1ms, so the slots, the trim and the drift loop count ms
+instead of carrier cycles. Register the tick with wwvb_ledc::attach(). cli() / sei() are
+a spinlock shared with the tick (wwvb_port.h). No second coil, ISR stats or round robin.
+
+-----------+-----------+-----------------
+Chip       | #define   | WWVB_OUT
+-----------+-----------+-----------------
+ATtiny85   |  USE_OC1A | D1 / PB1 (pin 6)
+ATtiny85   | *USE_OC1B | D4 / PB4 (pin 3)
+-----------+-----------+-----------------
+ATmega32u4 | *USE_OC1A | D9
+ATmega32u4 |  USE_OC1B | D10
+ATmega32u4 |  both     | D9 + D10 (two coils or an H-bridge, see set_output_b())
+-----------+-----------+-----------------
+ATmega328p | *USE_OC1A | D9
+ATmega328p |  USE_OC1B | D10
+ATmega328p |  both     | D9 + D10 (two coils or an H-bridge, see set_output_b())
+-----------+-----------+-----------------
+
+* Default setup
+*/
+
+#include <Arduino.h>
+#include "wwvb_port.h"
+#include <avr/pgmspace.h>
+#include "date_table.h"
+#include "epoch_clock.h"
+#include "timecode.h"
+#include "timecode_dst.h"
+
+#if defined(ESP8266)
+#error wwvb_frame.h : the ESP8266 has no hardware PWM for the carrier, ntp_time.h only (e.g. a clock display)
+#endif
+
+#if defined(__AVR_ATtiny25__) | defined(__AVR_ATtiny45__) | defined(__AVR_ATtiny85__)
+#define WWVB_ATTINY 1
+#if !defined(USE_OC1A) & !defined(USE_OC1B)
+#define USE_OC1B
+#endif
+#else
+#define WWVB_ATTINY 0
+#if !defined(USE_OC1A) & !defined(USE_OC1B)
+#define USE_OC1A
+#endif
+#endif
+
+// Both outputs, OC1A and OC1B
+#if defined(USE_OC1A) & defined(USE_OC1B)
+#define WWVB_DUAL 1
+#else
+#define WWVB_DUAL 0
+#endif
+
+#if (WWVB_DUAL == 1) & (WWVB_ATTINY == 1)
+#error Two outputs (USE_OC1A and USE_OC1B) need the ATmega Timer1
+#endif
+
+#if (WWVB_DUAL == 1) & defined(ESP32)
+#error Two outputs (USE_OC1A and USE_OC1B) need the ATmega Timer1, the ESP32 LEDC drives one pin
+#endif
+
+#define WWVB_PHASE_0 0
+#define WWVB_PHASE_180 1 // OC1B inverted, the other leg of an H-bridge
+
+#if defined(USE_OC1A)
+#define WWVB_OCR OCR1A
+#else
+#define WWVB_OCR OCR1B
+#endif
+
+#ifndef WWVB_ISR_STATS
+#define WWVB_ISR_STATS 0
+#endif
+
+#if (WWVB_ISR_STATS == 1) & ((WWVB_ATTINY == 1) | defined(ESP32))
+#error WWVB_ISR_STATS needs the 16 bit Timer1 (ATmega)
+#endif
+
+#define WWVB_STATS_BINS 9
+#define WWVB_STATS_SHIFT 5 // 32 CPU cycles per histogram bin
+
+struct wwvb_isr_stats
+{
+	uint32_t count;
+	uint16_t latency_min, latency_max;
+	uint16_t duration_min, duration_max;
+	uint16_t overrun; // another overflow was already pending on exit
+	uint16_t lost; // carrier cycles without an overflow interrupt, against micros()
+	uint32_t latency[WWVB_STATS_BINS];
+};
+
+#ifndef WWVB_LOOPBACK
+#define WWVB_LOOPBACK 0
+#endif
+
+#ifndef WWVB_LOOPBACK_TOLERANCE_MS
+#define WWVB_LOOPBACK_TOLERANCE_MS 25
+#endif
+
+#define WWVB_LOOPBACK_SECONDS 60
+
+#ifndef WWVB_DRIFT
+#define WWVB_DRIFT 0
+#endif
+
+#define WWVB_DRIFT_SPAN 600 // seconds, a rate is measured over the resync cycle or longer
+#define WWVB_DRIFT_SPAN_MAX 1800 // a longer gap (e.g. a standby) starts over
+#define WWVB_DRIFT_DEADBAND_PPB 5000
+#define WWVB_DRIFT_MAX_PPB 10000000L // 1%, a larger rate is a bad reference
+
+struct wwvb_drift_stats
+{
+	uint16_t count; // rates measured
+	uint16_t corrections; // rates taken out of the trim
+	int32_t offset_us; // at the last reference, +ve : the transmitter second starts late
+	int32_t rate_ppb; // the last rate error, +ve : the transmitted seconds are long
+	int32_t worst_ppb; // largest |rate_ppb|
+	uint16_t span; // seconds the last rate was measured over
+};
+
+// A transmitted second as the ISR emitted it
+struct wwvb_loopback_second
+{
+	uint16_t slots; // intended reduced power slots (bits 0 - 9), the second (bits 10 - 15)
+	uint8_t low; // measured reduced power time, 4.096ms (micros() >> 12)
+	int8_t length; // measured second - 1s, 1.024ms (micros() >> 10)
+};
+
+struct wwvb_loopback_stats
+{
+	uint32_t seconds;
+	uint32_t bad_seconds;
+	uint16_t bad_minutes; // minutes with at least one bad second
+	uint8_t last_minute; // bad seconds in the last complete minute
+	uint8_t worst_minute;
+	uint16_t worst_ms; // largest pulse width / second length error
+};
+
+#define WWVB_PWM_LOW_TRUE 255 // the reduced power level of the standard (LOW_Q16)
+
+#ifndef WWVB_PWM_LOW
+#define WWVB_PWM_LOW 0 // reduced power pulse width, percent of the high level (0 = carrier off)
+#endif
+
+#ifndef WWVB_ATTINY_PLL
+#define WWVB_ATTINY_PLL 0
+#endif
+
+#if (WWVB_ATTINY_PLL == 1) & (WWVB_ATTINY == 0)
+#error WWVB_ATTINY_PLL needs the ATtiny85 Timer1
+#endif
+
+// Timer1 clock
+#if (WWVB_ATTINY_PLL == 1)
+#define WWVB_TIMER_HZ ((F_CPU >= 16000000UL) ? F_CPU * 4 : F_CPU * 8)
+#else
+#define WWVB_TIMER_HZ F_CPU
+#endif
+
+#ifndef TIMECODE_CARRIER_PPM
+#define TIMECODE_CARRIER_PPM 5000 // largest carrier error that builds at all, e.g. 16MHz / 206 = 77.5kHz +2192ppm
+#endif
+
+#ifndef TIMECODE_CARRIER_HZ_RX
+#define TIMECODE_CARRIER_HZ_RX 25 // receiver pass band either side of the carrier, see the table above
+#endif
+
+#ifndef TIMECODE_CARRIER_STRICT
+#define TIMECODE_CARRIER_STRICT 1 // 0 : a carrier outside TIMECODE_CARRIER_HZ_RX builds (received next to the loop at best)
+#endif
+
+#ifndef WWVB_DITHER
+#define WWVB_DITHER 1 // 1 : TOP alternates between the whole periods either side, the average is the carrier
+#endif
+
+// Timer1 prescaler, 1 = CK (ATtiny : CK/2^(n-1) keeps TOP within 8 bits)
+constexpr uint8_t timecode_prescale(const uint32_t cpu_hz, const uint32_t hz, const uint8_t prescale = 1)
+{
+	return ((WWVB_ATTINY == 1) & (prescale < 15) & (((WWVB_DITHER == 1) ? ((cpu_hz >> (prescale - 1)) + hz - 1) / hz
+		: ((cpu_hz + hz / 2) / hz) >> (prescale - 1)) > 256)) ?
+		timecode_prescale(cpu_hz, hz, prescale + 1) : prescale;
+}
+
+// Timer clocks per carrier cycle (TOP + 1)
+constexpr uint32_t timecode_timer_hz(const uint32_t cpu_hz, const uint32_t hz)
+{
+	return cpu_hz >> (timecode_prescale(cpu_hz, hz) - 1);
+}
+
+// WWVB_DITHER : the shorter of the two periods, otherwise the nearest
+constexpr uint16_t timecode_period(const uint32_t cpu_hz, const uint32_t hz)
+{
+	return (WWVB_DITHER == 1) ? timecode_timer_hz(cpu_hz, hz) / hz : (timecode_timer_hz(cpu_hz, hz) + hz / 2) / hz;
+}
+
+// WWVB_DITHER : Q16 timer clocks per cycle above the period, the share of cycles that are a clock longer
+// (the remainder / hz in two 8 bit steps, the remainder << 16 does not fit 32 bits)
+constexpr uint16_t timecode_period_frac(const uint32_t cpu_hz, const uint32_t hz)
+{
+	return (WWVB_DITHER == 1) ? ((((timecode_timer_hz(cpu_hz, hz) % hz) << 8) / hz) << 8)
+		| (((((timecode_timer_hz(cpu_hz, hz) % hz) << 8) % hz) << 8) / hz) : 0;
+}
+
+// WWVB_DITHER : what the Q16 fraction leaves over, in 1/65536 timer clocks per second
+constexpr uint32_t timecode_period_rem(const uint32_t cpu_hz, const uint32_t hz)
+{
+	return (WWVB_DITHER == 1) ? ((((timecode_timer_hz(cpu_hz, hz) % hz) << 8) % hz) << 8) % hz : 0;
+}
+
+// Longest carrier period (TOP + 1), the dithered cycles are a clock longer
+constexpr uint16_t timecode_period_long(const uint32_t cpu_hz, const uint32_t hz)
+{
+	return timecode_period(cpu_hz, hz) + (timecode_period_frac(cpu_hz, hz) != 0);
+}
+
+// Reduced power pulse width in timer clocks, percent of the high level or WWVB_PWM_LOW_TRUE
+constexpr uint16_t timecode_duty_low(const uint16_t period, const uint8_t percent, const uint16_t low_q16)
+{
+	return (percent == WWVB_PWM_LOW_TRUE) ? (static_cast<uint32_t>(period) * low_q16 + 0x8000UL) >> 16
+		: (static_cast<uint32_t>(period >> 1) * percent) / 100;
+}
+
+// Carrier cycles (timer overflows) per second, WWVB_DITHER : hz and under one cycle
+constexpr uint32_t timecode_cycles_per_second(const uint32_t cpu_hz, const uint32_t hz)
+{
+	return (WWVB_DITHER == 1) ? hz : timecode_timer_hz(cpu_hz, hz) / timecode_period(cpu_hz, hz);
+}
+
+// Carrier frequency error in ppm (+ve : above hz), WWVB_DITHER : well under 0.001ppm
+constexpr int32_t timecode_carrier_ppm(const uint32_t cpu_hz, const uint32_t hz)
+{
+	return (WWVB_DITHER == 1) ? 0 : (static_cast<int32_t>(timecode_timer_hz(cpu_hz, hz)) - static_cast<int32_t>(hz * timecode_period(cpu_hz, hz))) * 1000L
+		/ static_cast<int32_t>((hz * timecode_period(cpu_hz, hz)) / 1000);
+}
+
+constexpr bool timecode_carrier_ok(const uint32_t cpu_hz, const uint32_t hz)
+{
+	return (timecode_period(cpu_hz, hz) >= 16) & (timecode_period_long(cpu_hz, hz) <= ((WWVB_ATTINY == 1) ? 256 : 65535))
+		& (timecode_carrier_ppm(cpu_hz, hz) <= TIMECODE_CARRIER_PPM) & (timecode_carrier_ppm(cpu_hz, hz) >= -TIMECODE_CARRIER_PPM);
+}
+
+// Carrier frequency error in Hz, hz is the carrier_hz interrupt rate (the backend tick_hz())
+constexpr int16_t timecode_carrier_error_hz(const uint32_t cpu_hz, const uint32_t hz, const uint32_t carrier_hz)
+{
+	return (timecode_carrier_ppm(cpu_hz, hz) * static_cast<int32_t>(carrier_hz / 10)
+		+ ((timecode_carrier_ppm(cpu_hz, hz) < 0) ? -50000L : 50000L)) / 100000L;
+}
+
+// The carrier is inside the receiver pass band
+constexpr bool timecode_carrier_rx(const uint32_t cpu_hz, const uint32_t hz, const uint32_t carrier_hz)
+{
+	return (timecode_carrier_error_hz(cpu_hz, hz, carrier_hz) <= TIMECODE_CARRIER_HZ_RX)
+		& (timecode_carrier_error_hz(cpu_hz, hz, carrier_hz) >= -TIMECODE_CARRIER_HZ_RX);
+}
+
+// Timer1 settings and second timing for a carrier
+struct timecode_carrier
+{
+	uint32_t ticks_per_second;
+	uint16_t ticks_slot; // 100ms
+	uint16_t ticks_last; // the last slot has the remainder of the second
+	uint16_t ticks_frac; // fractional cycles per second (Q16)
+	uint16_t top;
+	uint16_t top_frac; // Q16 clocks per cycle above top + 1, see WWVB_DITHER
+	uint16_t duty_high, duty_low;
+#if (WWVB_DUAL == 1)
+	uint16_t duty_high_b, duty_low_b; // OC1B
+#endif
+	uint8_t prescale;
+};
+
+// Add a rate correction (Q16 cycles per second), whole cycles go into the last slot
+inline void timecode_carrier_correct(timecode_carrier &c, const int32_t correction)
+{
+	const int32_t frac = static_cast<int32_t>(c.ticks_frac) + (correction & 0xFFFFL);
+	const int16_t whole = (correction >> 16) + (frac >> 16);
+	c.ticks_frac = frac;
+	c.ticks_per_second += whole;
+	c.ticks_last += whole;
+}
+
+// Fractional cycles per second (Q16) left over by the carrier period
+constexpr uint16_t timecode_cycles_frac(const uint32_t cpu_hz, const uint32_t hz)
+{
+	return (WWVB_DITHER == 1) ? (timecode_period_rem(cpu_hz, hz) << 8)
+		/ ((static_cast<uint32_t>(timecode_period(cpu_hz, hz)) << 8) + (timecode_period_frac(cpu_hz, hz) >> 8))
+		: ((timecode_timer_hz(cpu_hz, hz) % timecode_period(cpu_hz, hz)) << 16) / timecode_period(cpu_hz, hz);
+}
+
+// Compile time Timer1 settings for a carrier
+// HZ : interrupts per second (the backend tick_hz()) on a CLOCK_HZ timer clock
+template <uint32_t HZ, uint16_t LOW_Q16, uint32_t CLOCK_HZ = WWVB_TIMER_HZ>
+struct timecode_timer
+{
+	static_assert(timecode_carrier_ok(CLOCK_HZ, HZ), "F_CPU can not make the carrier within TIMECODE_CARRIER_PPM");
+
+	static const uint8_t PRESCALE = timecode_prescale(CLOCK_HZ, HZ);
+	static const uint16_t PERIOD = timecode_period(CLOCK_HZ, HZ);
+	static const uint16_t TOP = PERIOD - 1;
+	static const uint16_t TOP_FRAC = timecode_period_frac(CLOCK_HZ, HZ);
+	static const uint16_t DUTY_HIGH = PERIOD >> 1;
+	static const uint16_t DUTY_LOW = timecode_duty_low(PERIOD, WWVB_PWM_LOW, LOW_Q16);
+	static const uint32_t TICKS_PER_SECOND = timecode_cycles_per_second(CLOCK_HZ, HZ);
+	static const uint16_t TICKS_SLOT = TICKS_PER_SECOND / TIMECODE_SLOTS;
+	static const uint16_t TICKS_LAST = TICKS_PER_SECOND - (TIMECODE_SLOTS - 1) * TICKS_SLOT;
+	static const uint16_t TICKS_FRAC = timecode_cycles_frac(CLOCK_HZ, HZ);
+
+	// correction : Q16 carrier cycles per second, percent : reduced power level (setPWM_LOW())
+	static void setup(timecode_carrier &c, const int32_t correction, const uint8_t percent)
+	{
+		c.top = TOP;
+		c.top_frac = TOP_FRAC;
+		c.prescale = PRESCALE;
+		c.duty_high = DUTY_HIGH;
+		c.duty_low = (percent == WWVB_PWM_LOW) ? DUTY_LOW : timecode_duty_low(PERIOD, percent, LOW_Q16);
+		c.ticks_per_second = TICKS_PER_SECOND;
+		c.ticks_slot = TICKS_SLOT;
+		c.ticks_last = TICKS_LAST;
+		c.ticks_frac = TICKS_FRAC;
+		timecode_carrier_correct(c, correction);
+	}
+};
+
+// Run time version for the round robin carriers, same math as timecode_timer<>
+// steps : timer interrupts per carrier cycle (the backend STEPS)
+inline void timecode_carrier_setup(timecode_carrier &c, const uint8_t standard, const int32_t correction, const uint8_t percent,
+	const uint8_t steps = 1)
+{
+	const uint32_t hz = timecode_carrier_hz(standard) * steps;
+	const uint16_t period = timecode_period(WWVB_TIMER_HZ, hz);
+	c.top = period - 1;
+	c.top_frac = timecode_period_frac(WWVB_TIMER_HZ, hz);
+	c.prescale = timecode_prescale(WWVB_TIMER_HZ, hz);
+	c.duty_high = period >> 1;
+	c.duty_low = timecode_duty_low(period, percent, timecode_low_q16(standard));
+	c.ticks_per_second = timecode_cycles_per_second(WWVB_TIMER_HZ, hz);
+	c.ticks_slot = c.ticks_per_second / TIMECODE_SLOTS;
+	c.ticks_last = c.ticks_per_second - (TIMECODE_SLOTS - 1) * c.ticks_slot;
+	c.ticks_frac = timecode_cycles_frac(WWVB_TIMER_HZ, hz);
+	timecode_carrier_correct(c, correction);
+}
+
+#if (WWVB_DUAL == 1)
+// OC1B pulse widths for a carrier, WWVB_PHASE_180 (inverting) sets OC1B at the compare match
+// so the pulse is TOP + 1 - OCR1B long, a compare past TOP never sets it (carrier off)
+inline void timecode_carrier_output_b(timecode_carrier &c, const uint16_t low_q16, const uint8_t phase, const uint8_t percent)
+{
+	const uint16_t period = c.top + 1;
+	const uint16_t high = period >> 1;
+	const uint16_t low = timecode_duty_low(period, percent, low_q16);
+	c.duty_high_b = (phase == WWVB_PHASE_180) ? period - high : high;
+	c.duty_low_b = (phase == WWVB_PHASE_180) ? period - low : low;
+}
+#endif
+
+/*
+Carrier timer backends, the TIMER of timecode_tx<STANDARD, TIMER>
+STEPS      : interrupts per carrier cycle, the ISR counts these (the "carrier cycles" of the second timing and the trim)
+PERIOD_MAX : largest TOP + 1
+PWM        : the reduced power level is a pulse width, otherwise it is always carrier off
+ROTATION   : top() can change the carrier, i.e. TIMECODE_ROUND_ROBIN
+CLOCK_HZ   : the timer clock, tick_hz(carrier) : interrupts per second for a carrier
+sync()     : called with the interrupts on after start() / stop() (and the output() with them),
+             for the driver calls that can't be made with them off (the LEDC and esp_timer)
+dither(top): TOP of the cycle that has just started (WWVB_DITHER), false once the counter is
+             too close to it to change (a late interrupt), the ISR tries again next cycle
+*/
+
+#if !defined(ESP32)
+
+// Timer1 fast PWM on OC1A / OC1B, ISR(TIMER1_OVF_vect), the default
+// ATmega : mode 14, TOP = ICR1, no prescaler. ATtiny85 : PWM1A / PWM1B, TOP = OCR1C, CK/2^(n-1)
+struct wwvb_timer1
+{
+	static const uint8_t NUMBER = 1;
+	static const uint8_t STEPS = 1;
+	static const uint16_t PERIOD_MAX = (WWVB_ATTINY == 1) ? 256 : 65535;
+	static const bool PWM = true;
+	static const bool ROTATION = true;
+	static const uint32_t CLOCK_HZ = WWVB_TIMER_HZ;
+
+	static constexpr uint32_t tick_hz(const uint32_t carrier_hz)
+	{
+		return carrier_hz * STEPS;
+	}
+
+	static void setup(const uint32_t)
+	{
+#if (WWVB_ATTINY == 1)
+#if (WWVB_ATTINY_PLL == 1)
+		// PCK : wait for the PLL to lock before switching Timer1 to it
+		PLLCSR = _BV(PLLE);
+		delayMicroseconds(100);
+		while (!(PLLCSR & _BV(PLOCK))) {}
+		PLLCSR |= _BV(PCKE);
+#endif
+#if defined(USE_OC1A)
+		DDRB |= _BV(PB1);
+		TCCR1 = _BV(PWM1A) | _BV(COM1A1);
+#else
+		DDRB |= _BV(PB4);
+		GTCCR = _BV(PWM1B) | _BV(COM1B1);
+		TCCR1 = 0;
+#endif
+#else
+		// fast PWM (mode 14, TOP = ICR1), no prescaler
+#if defined(USE_OC1A)
+		pinMode(9, OUTPUT);
+		TCCR1A = _BV(COM1A1) | _BV(WGM11);
+#else
+		pinMode(10, OUTPUT);
+		TCCR1A = _BV(COM1B1) | _BV(WGM11);
+#endif
+		TCCR1B = _BV(WGM13) | _BV(WGM12) | _BV(CS10);
+#endif
+	}
+
+	static inline void top(const timecode_carrier &c)
+	{
+#if (WWVB_ATTINY == 1)
+		OCR1C = c.top;
+		TCCR1 = (TCCR1 & 0xF0) | c.prescale;
+#else
+		ICR1 = c.top;
+#endif
+	}
+
+	// TOP isn't buffered, moved under a counter more than 16 clocks short of it
+	static inline bool dither(const uint16_t top)
+	{
+#if (WWVB_ATTINY == 1)
+		if (TCNT1 + 16 >= top)
+		{
+			return false;
+		}
+		OCR1C = top;
+#else
+		if (TCNT1 + 16 >= top)
+		{
+			return false;
+		}
+		ICR1 = top;
+#endif
+		return true;
+	}
+
+	static inline uint16_t period()
+	{
+#if (WWVB_ATTINY == 1)
+		return OCR1C + 1;
+#else
+		return ICR1 + 1;
+#endif
+	}
+
+	static inline void output(const uint16_t duty)
+	{
+		WWVB_OCR = duty;
+	}
+
+	// with interrupts off
+	static inline void start()
+	{
+#if (WWVB_ATTINY == 1)
+		TIFR = _BV(TOV1);
+		TIMSK |= _BV(TOIE1);
+#else
+		TCNT1 = 0;
+		TIFR1 = _BV(TOV1);
+		TIMSK1 |= _BV(TOIE1);
+#endif
+	}
+
+	static inline void stop()
+	{
+#if (WWVB_ATTINY == 1)
+		// TIMSK is shared with Timer0 (tiny_uart.h sets OCIE0B in its ISRs)
+		cli();
+		TIMSK &= ~_BV(TOIE1);
+		sei();
+#else
+		TIMSK1 &= ~_BV(TOIE1);
+#endif
+	}
+
+	// An overflow is waiting behind the one being handled (not checked on the ATtiny85)
+	static inline bool pending()
+	{
+#if (WWVB_ATTINY == 1)
+		return false;
+#else
+		return TIFR1 & _BV(TOV1);
+#endif
+	}
+
+	static inline uint16_t count()
+	{
+		return TCNT1;
+	}
+
+	static inline void sync() {}
+};
+
+#if (WWVB_ATTINY == 0) & !(defined(__AVR_ATmega16U4__) | defined(__AVR_ATmega32U4__))
+// Timer2 CTC (TOP = OCR2A) toggling OC2A (D11 on the 328p), ISR(TIMER2_COMPA_vect), leaves Timer1
+// free for input capture. Every compare match toggles the pin, so there are two interrupts per
+// carrier cycle and the trim is in half cycles : 16MHz / 2 / 133.33 = 60kHz with WWVB_DITHER
+// (133, 133, 134, ... clocks a half cycle, 60.150kHz +150Hz fixed at 133), JJY40 40kHz exactly.
+// CTC has no pulse width, the reduced power level is always carrier off (OC2A disconnected, the pin is low).
+// Note : D11 is MOSI, the SPI bus (e.g. the Nokia 5110) can't share it
+struct wwvb_timer2
+{
+	static const uint8_t NUMBER = 2;
+	static const uint8_t STEPS = 2;
+	static const uint16_t PERIOD_MAX = 256;
+	static const bool PWM = false;
+	static const bool ROTATION = true;
+	static const uint32_t CLOCK_HZ = F_CPU;
+
+	static constexpr uint32_t tick_hz(const uint32_t carrier_hz)
+	{
+		return carrier_hz * STEPS;
+	}
+
+	static void setup(const uint32_t)
+	{
+		pinMode(11, OUTPUT);
+		digitalWrite(11, LOW);
+		TCCR2A = _BV(WGM21);
+		TCCR2B = _BV(CS20);
+	}
+
+	// OCR2A isn't buffered in CTC, like ICR1 it is only changed just after the compare match
+	static inline void top(const timecode_carrier &c)
+	{
+		OCR2A = c.top;
+	}
+
+	static inline bool dither(const uint16_t top)
+	{
+		if (TCNT2 + 16 >= top)
+		{
+			return false;
+		}
+		OCR2A = top;
+		return true;
+	}
+
+	static inline uint16_t period()
+	{
+		return OCR2A + 1;
+	}
+
+	// duty 0 : carrier off, otherwise OC2A toggles on every compare match
+	static inline void output(const uint16_t duty)
+	{
+		TCCR2A = duty ? (_BV(COM2A0) | _BV(WGM21)) : _BV(WGM21);
+	}
+
+	// with interrupts off
+	static inline void start()
+	{
+		TCNT2 = 0;
+		TIFR2 = _BV(OCF2A);
+		TIMSK2 |= _BV(OCIE2A);
+	}
+
+	static inline void stop()
+	{
+		TIMSK2 &= ~_BV(OCIE2A);
+	}
+
+	static inline bool pending()
+	{
+		return TIFR2 & _BV(OCF2A);
+	}
+
+	static inline uint16_t count()
+	{
+		return TCNT2;
+	}
+
+	static inline void sync() {}
+};
+#endif
+
+#define WWVB_TIMER_DEFAULT wwvb_timer1
+#else
+#include "wwvb_ledc.h"
+#define WWVB_TIMER_DEFAULT wwvb_ledc
+#endif
+
+#define TIMECODE_ROTATION_MAX 6
+
+// Standard and timezone (added to the time given to set_time()) of a rotation entry
+struct timecode_slot
+{
+	uint8_t standard;
+	int8_t tz_hh, tz_mm;
+};
+
+// Round robin : each entry of the PROGMEM table transmits for 'minutes' minutes in turn
+// The turn is worked out from the time, so it stays in step across GPS resyncs
+class timecode_rotation
+{
+public:
+	const timecode_slot *table;
+	uint8_t count;
+	uint8_t minutes;
+	timecode_carrier carrier[TIMECODE_ROTATION_MAX]; // filled in by timecode_tx
+	int32_t trim_q16[TIMECODE_ROTATION_MAX]; // the trim each carrier was worked out for, the PPS steps since are added on apply
+
+	timecode_rotation(const timecode_slot *slots, const uint8_t n, const uint8_t m = 1) :
+		table(slots), count((n > TIMECODE_ROTATION_MAX) ? TIMECODE_ROTATION_MAX : n), minutes(m) {}
+
+	uint8_t slot(const uint8_t hh, const uint8_t mm, const uint8_t DD, const uint8_t MM, const uint8_t YY)
+	{
+		const uint32_t minute = date_to_days(DD, MM, YY) * static_cast<uint32_t>(DATE_MINUTES_PER_DAY) + hh * 60U + mm;
+		return (minute / minutes) % count;
+	}
+
+	uint8_t standard(const uint8_t i) { return pgm_read_byte(&table[i].standard); }
+	int8_t tz_hh(const uint8_t i) { return pgm_read_byte(&table[i].tz_hh); }
+	int8_t tz_mm(const uint8_t i) { return pgm_read_byte(&table[i].tz_mm); }
+};
+
+template <uint8_t STANDARD, typename TIMER = WWVB_TIMER_DEFAULT>
+class timecode_tx
+{
+private:
+	typedef timecode_encoder<STANDARD> encoder;
+	typedef timecode_timer<TIMER::tick_hz(encoder::CARRIER_HZ), encoder::LOW_Q16, TIMER::CLOCK_HZ> carrier_timer;
+
+	static_assert((STANDARD != TIMECODE_ROUND_ROBIN) | TIMER::ROTATION, "The carrier timer can not change the carrier (round robin)");
+	// round robin : any carrier can be in the rotation
+	static_assert((STANDARD != TIMECODE_ROUND_ROBIN) | (timecode_carrier_ok(WWVB_TIMER_HZ, 40000UL * TIMER::STEPS) & timecode_carrier_ok(WWVB_TIMER_HZ, 60000UL * TIMER::STEPS)
+		& timecode_carrier_ok(WWVB_TIMER_HZ, 68500UL * TIMER::STEPS) & timecode_carrier_ok(WWVB_TIMER_HZ, 77500UL * TIMER::STEPS)), "F_CPU can not make the carriers within TIMECODE_CARRIER_PPM");
+	// the receiver pass band, round robin : every carrier the rotation can hold
+	static_assert((TIMECODE_CARRIER_STRICT == 0) | (STANDARD != TIMECODE_ROUND_ROBIN) | (timecode_carrier_rx(TIMER::CLOCK_HZ, TIMER::tick_hz(40000UL), 40000UL)
+		& timecode_carrier_rx(TIMER::CLOCK_HZ, TIMER::tick_hz(60000UL), 60000UL) & timecode_carrier_rx(TIMER::CLOCK_HZ, TIMER::tick_hz(68500UL), 68500UL)
+		& timecode_carrier_rx(TIMER::CLOCK_HZ, TIMER::tick_hz(77500UL), 77500UL)), "F_CPU can not make the carriers within TIMECODE_CARRIER_HZ_RX");
+	static_assert((TIMECODE_CARRIER_STRICT == 0) | (STANDARD == TIMECODE_ROUND_ROBIN) | timecode_carrier_rx(TIMER::CLOCK_HZ, TIMER::tick_hz(encoder::CARRIER_HZ), encoder::CARRIER_HZ),
+		"F_CPU can not make the carrier within TIMECODE_CARRIER_HZ_RX");
+	static_assert(timecode_period_long(TIMER::CLOCK_HZ, TIMER::tick_hz((STANDARD == TIMECODE_ROUND_ROBIN) ? 40000UL : encoder::CARRIER_HZ)) <= TIMER::PERIOD_MAX,
+		"F_CPU is too fast for the carrier timer");
+
+	struct frame_t
+	{
+		uint8_t bits[encoder::FRAME_BYTES];
+		uint8_t hh, mm, DD, MM, YY;
+		uint8_t flags; // TIMECODE_DST_* / TIMECODE_LEAP_MONTH
+		uint8_t slot; // timecode_rotation entry
+	};
+
+	frame_t _frame[2];
+	volatile uint8_t _active;
+	volatile bool _next_ready;
+	volatile bool _is_active;
+
+	volatile uint8_t _ss;
+	volatile uint16_t _count;
+	volatile uint8_t _slot;
+	volatile uint16_t _slots; // reduced power slots left in this second, bit 0 = current slot
+	volatile uint16_t _last_slot; // length of the last slot, including the PPS adjustment
+
+	// the PPS interrupt steps the trim and the second timing, read and write them with the interrupts off
+	volatile uint32_t _ticks_per_second;
+	uint16_t _ticks_slot; // 100ms
+	volatile uint16_t _ticks_last; // the last slot has the remainder of the second
+	volatile uint16_t _ticks_frac; // fractional cycles per second (Q16)
+	uint16_t _phase; // fractional cycle accumulator, ISR only
+#if (WWVB_DITHER == 1)
+	uint16_t _top, _top_frac; // the shorter TOP and the Q16 share of cycles a clock longer
+	uint16_t _top_phase; // ISR only
+#endif
+	uint16_t _duty_high;
+	uint16_t _duty_low;
+	uint8_t _percent;
+#if (WWVB_DUAL == 1)
+	uint16_t _duty_high_b;
+	uint16_t _duty_low_b;
+	uint8_t _phase_b;
+	uint8_t _percent_b;
+#endif
+	volatile int32_t _trim_q16; // rate correction, Q16 carrier cycles per second
+
+	timecode_rotation *_rotation;
+
+	// PPS discipline state
+	volatile int16_t _pps_adjust;
+	volatile bool _pps_pending;
+	volatile int16_t _pps_error;
+	volatile uint8_t _pps_good; // edges within 8 cycles, see pps_good_seconds()
+
+	int8_t _tz_hh, _tz_mm;
+
+	uint8_t _dst_rule;
+	int8_t _dut1;
+	uint8_t _leap_MM, _leap_YY;
+
+#if (WWVB_ISR_STATS == 1)
+	wwvb_isr_stats _stats;
+	uint32_t _stats_us; // micros() at the reference overflow
+	uint16_t _stats_entry; // its TCNT1 on entry
+	uint8_t _stats_n; // overflows since the reference
+	bool _stats_ref; // false after a start or a carrier change
+
+	// 256 carrier cycles in CPU clocks
+	inline uint32_t stats_window()
+	{
+#if (WWVB_DITHER == 1)
+		return (static_cast<uint32_t>(_top + 1) << 8) + (_top_frac >> 8);
+#else
+		return static_cast<uint32_t>(TIMER::period()) << 8;
+#endif
+	}
+
+	inline void record(const uint16_t t_entry, const uint16_t t_exit)
+	{
+		const uint16_t duration = (t_exit >= t_entry) ? t_exit - t_entry : t_exit + TIMER::period() - t_entry;
+		++_stats.count;
+		if (t_entry < _stats.latency_min) { _stats.latency_min = t_entry; }
+		if (t_entry > _stats.latency_max) { _stats.latency_max = t_entry; }
+		if (duration < _stats.duration_min) { _stats.duration_min = duration; }
+		if (duration > _stats.duration_max) { _stats.duration_max = duration; }
+		uint8_t bin = t_entry >> WWVB_STATS_SHIFT;
+		if (bin >= WWVB_STATS_BINS)
+		{
+			bin = WWVB_STATS_BINS - 1;
+		}
+		++_stats.latency[bin];
+		if (TIMER::pending())
+		{
+			++_stats.overrun;
+		}
+		if (++_stats_n == 0)
+		{
+			const uint32_t t_us = micros();
+			if (_stats_ref)
+			{
+				// the overflows were t_entry / _stats_entry before the ISRs, less any whole cycles TCNT1 wrapped
+				int32_t extra = static_cast<int32_t>((t_us - _stats_us) * (F_CPU / 1000000UL) - stats_window())
+					- t_entry + _stats_entry;
+				const int16_t period = TIMER::period();
+				while (extra > period / 2)
+				{
+					++_stats.lost;
+					extra -= period;
+				}
+			}
+			_stats_us = t_us;
+			_stats_entry = t_entry;
+			_stats_ref = true;
+		}
+	}
+#endif
+
+#if (WWVB_LOOPBACK == 1)
+	wwvb_loopback_second _lb_ring[WWVB_LOOPBACK_SECONDS];
+	volatile uint8_t _lb_head; // next entry the ISR writes
+	uint8_t _lb_tail; // next entry update() decodes
+	bool _lb_started;
+	bool _lb_low_on;
+	uint8_t _lb_ss;
+	uint16_t _lb_slots;
+	uint32_t _lb_t_second, _lb_t_low, _lb_low;
+	uint8_t _lb_minute_bad;
+	wwvb_loopback_stats _lb;
+
+	// At the start of every slot, slots is the reduced power mask from this slot on
+	inline void trace(const uint8_t slot, const uint16_t slots)
+	{
+		const bool low = slots & 0x01;
+		if ((slot != 0) & (low == _lb_low_on))
+		{
+			return;
+		}
+		const uint32_t t = micros();
+		if (_lb_low_on)
+		{
+			_lb_low += t - _lb_t_low;
+		}
+		_lb_low_on = low;
+		_lb_t_low = t;
+		if (slot != 0)
+		{
+			return;
+		}
+
+		if (_lb_started)
+		{
+			// the second that just ended
+			wwvb_loopback_second &e = _lb_ring[_lb_head];
+			const int32_t length = static_cast<int32_t>(t - _lb_t_second - 1000000UL) >> 10;
+			const uint32_t low_time = _lb_low >> 12;
+			e.slots = _lb_slots | (static_cast<uint16_t>(_lb_ss) << 10);
+			e.low = (low_time > 0xFF) ? 0xFF : low_time;
+			e.length = (length > 127) ? 127 : (length < -127) ? -127 : length;
+			const uint8_t head = _lb_head + 1;
+			_lb_head = (head == WWVB_LOOPBACK_SECONDS) ? 0 : head;
+		}
+		_lb_started = true;
+		_lb_t_second = t;
+		_lb_low = 0;
+		_lb_slots = slots;
+		_lb_ss = _ss;
+	}
+
+	// Foreground : decode the seconds the ISR traced since the last call
+	void loopback_decode()
+	{
+		while (_lb_tail != _lb_head)
+		{
+			const wwvb_loopback_second &e = _lb_ring[_lb_tail];
+			const uint8_t tail = _lb_tail + 1;
+			_lb_tail = (tail == WWVB_LOOPBACK_SECONDS) ? 0 : tail;
+
+			uint8_t symbol = 0; // the intended reduced power time, 100ms slots
+			for (uint16_t slots = e.slots & 0x03FF; slots; slots >>= 1)
+			{
+				symbol += slots & 0x01;
+			}
+			const int16_t low_ms = (e.low * 4096L + 500) / 1000;
+			const int16_t length_ms = (e.length * 1024L) / 1000;
+			const int16_t nominal_ms = symbol * 100;
+			const uint16_t low_error = (low_ms > nominal_ms) ? low_ms - nominal_ms : nominal_ms - low_ms;
+			const uint16_t length_error = (length_ms < 0) ? -length_ms : length_ms;
+			const uint16_t error = (low_error > length_error) ? low_error : length_error;
+
+			++_lb.seconds;
+			if (error > _lb.worst_ms)
+			{
+				_lb.worst_ms = error;
+			}
+			if ((error > WWVB_LOOPBACK_TOLERANCE_MS) & (_lb_minute_bad < 0xFF))
+			{
+				++_lb.bad_seconds;
+				++_lb_minute_bad;
+			}
+			if ((e.slots >> 10) == 59)
+			{
+				_lb.last_minute = _lb_minute_bad;
+				if (_lb_minute_bad > _lb.worst_minute)
+				{
+					_lb.worst_minute = _lb_minute_bad;
+				}
+				if (_lb_minute_bad)
+				{
+					++_lb.bad_minutes;
+				}
+				_lb_minute_bad = 0;
+			}
+		}
+	}
+#endif
+
+#if (WWVB_DRIFT == 1)
+	volatile uint32_t _dr_us; // micros() at the start of the last transmitted second
+	volatile uint32_t _dr_seconds; // transmitted seconds since start()
+	uint32_t _dr_label; // clock time of the second start() started
+	bool _dr_started;
+	uint32_t _dr_ref_t, _dr_ref_us; // the last reference
+	bool _dr_ref;
+	uint32_t _dr_base_t; // the reference the rate is measured from
+	int32_t _dr_base_offset;
+	bool _dr_base;
+	bool _dr_auto;
+	wwvb_drift_stats _dr;
+
+	// Second 0 starts now, a start on the minute just referenced (the GPS resync) is the new baseline
+	void drift_start()
+	{
+		const uint32_t t = clock.now();
+		const uint32_t t_us = micros();
+		_dr_base = _dr_ref & (t == _dr_ref_t);
+		_dr_base_t = t;
+		_dr_base_offset = t_us - _dr_ref_us;
+		_dr_ref = false;
+		_dr_label = t;
+		cli();
+		_dr_us = t_us;
+		_dr_seconds = 0;
+		sei();
+		_dr_started = true;
+	}
+#endif
+
+	// Carrier cycle count, see interrupt_routine()
+	inline void tick()
+	{
+#if (WWVB_DITHER == 1)
+		if (_top_frac)
+		{
+			// TOP of the cycle that has just started, the carry of the phase makes it a clock longer
+			const uint16_t top_phase = _top_phase + _top_frac;
+			if (TIMER::dither(_top + (top_phase < _top_phase)))
+			{
+				_top_phase = top_phase;
+			}
+		}
+#endif
+		if (--_count)
+		{
+			return;
+		}
+
+		uint8_t slot = _slot + 1;
+		uint16_t slots = _slots >> 1;
+		if (slot == TIMECODE_SLOTS)
+		{
+			// start of a second
+			slot = 0;
+			clock.tick();
+#if (WWVB_DRIFT == 1)
+			_dr_us = micros();
+			++_dr_seconds;
+#endif
+			uint8_t ss = _ss + 1;
+			if (ss == 60)
+			{
+				ss = 0;
+				if (_next_ready)
+				{
+					_active ^= 1;
+					_next_ready = false;
+					if (multi())
+					{
+						// TOP is not buffered in mode 14, but the counter has only just restarted
+						apply_rotation(_frame[_active].slot);
+					}
+				}
+			}
+			_ss = ss;
+			slots = encoder::slots(_frame[_active].bits, ss);
+		}
+		_slot = slot;
+		_slots = slots;
+
+		TIMER::output((slots & 0x01) ? _duty_low : _duty_high);
+#if (WWVB_DUAL == 1)
+		output_b((slots & 0x01) ? _duty_low_b : _duty_high_b);
+#endif
+#if (WWVB_LOOPBACK == 1)
+		trace(slot, slots);
+#endif
+		if (slot == TIMECODE_SLOTS - 1)
+		{
+			// line the end of the second up with the PPS edge, the carry of the fractional cycles lengthens it
+			const uint16_t phase = _phase + _ticks_frac;
+			_count = _last_slot = _ticks_last + _pps_adjust + (phase < _phase);
+			_phase = phase;
+			_pps_adjust = 0;
+			_pps_pending = false;
+		}
+		else
+		{
+			_count = _ticks_slot;
+		}
+	}
+
+#if (WWVB_DUAL == 1)
+	// OC1B is on Timer1, the Timer2 backend only drives OC2A
+	static const bool DUAL = (TIMER::NUMBER == 1);
+
+	inline void output_b(const uint16_t duty)
+	{
+		if (DUAL)
+		{
+			OCR1B = duty;
+		}
+	}
+
+	// OC1B carrier off : 0, or inverted a compare past TOP
+	uint16_t off_b()
+	{
+#if (WWVB_DITHER == 1)
+		return (_phase_b == WWVB_PHASE_180) ? _top + 2 : 0; // past the longer TOP too
+#else
+		return (_phase_b == WWVB_PHASE_180) ? TIMER::period() : 0;
+#endif
+	}
+#endif
+
+	bool multi()
+	{
+		return (STANDARD == TIMECODE_ROUND_ROBIN) & (_rotation != 0);
+	}
+
+	inline void apply(const timecode_carrier &c)
+	{
+		TIMER::top(c);
+#if (WWVB_ISR_STATS == 1)
+		_stats_ref = false;
+#endif
+#if (WWVB_DITHER == 1)
+		_top = c.top;
+		_top_frac = c.top_frac;
+#endif
+		_ticks_per_second = c.ticks_per_second;
+		_ticks_slot = c.ticks_slot;
+		_ticks_last = c.ticks_last;
+		_ticks_frac = c.ticks_frac;
+		_duty_high = c.duty_high;
+		_duty_low = c.duty_low;
+#if (WWVB_DUAL == 1)
+		_duty_high_b = c.duty_high_b;
+		_duty_low_b = c.duty_low_b;
+#endif
+	}
+
+	// Add a rate correction to the second timing in use, as timecode_carrier_correct()
+	inline void step_ticks(const int32_t step)
+	{
+		const int32_t frac = static_cast<int32_t>(_ticks_frac) + (step & 0xFFFFL);
+		const int16_t whole = (step >> 16) + (frac >> 16);
+		_ticks_frac = frac;
+		_ticks_per_second += whole;
+		_ticks_last += whole;
+	}
+
+	// A carrier worked out for trim, with the PPS steps made since, with the interrupts off
+	inline void apply(const timecode_carrier &c, const int32_t trim)
+	{
+		apply(c);
+		if (_trim_q16 != trim)
+		{
+			step_ticks(_trim_q16 - trim);
+		}
+	}
+
+	inline void apply_rotation(const uint8_t i)
+	{
+		apply(_rotation->carrier[i], _rotation->trim_q16[i]);
+	}
+
+	// Round robin : the correction is in cycles of the first carrier, scaled for the others
+	// Each carrier is worked out with the interrupts on and copied in with them off, the ISR loads them on the minute
+	void set_carriers(const int32_t trim)
+	{
+		const float hz_trim = timecode_carrier_hz(_rotation->standard(0));
+		for (uint8_t i = 0; i < _rotation->count; ++i)
+		{
+			const uint8_t standard = _rotation->standard(i);
+			const float scale = timecode_carrier_hz(standard) / hz_trim;
+			timecode_carrier c;
+			timecode_carrier_setup(c, standard, static_cast<int32_t>(trim * scale), _percent, TIMER::STEPS);
+#if (WWVB_DUAL == 1)
+			timecode_carrier_output_b(c, timecode_low_q16(standard), _phase_b, _percent_b);
+#endif
+			cli();
+			_rotation->carrier[i] = c;
+			_rotation->trim_q16[i] = trim;
+			sei();
+		}
+	}
+
+	// The carrier is worked out from a copy of the trim, a PPS step in the meantime is added when it is applied
+	void set_ticks()
+	{
+		const int32_t trim = trim_q16();
+		if (multi())
+		{
+			set_carriers(trim);
+			cli();
+			apply_rotation(_frame[_active].slot);
+			sei();
+			return;
+		}
+		timecode_carrier c;
+		carrier_timer::setup(c, trim, _percent);
+#if (WWVB_DUAL == 1)
+		timecode_carrier_output_b(c, encoder::LOW_Q16, _phase_b, _percent_b);
+#endif
+		cli();
+		apply(c, trim);
+		sei();
+	}
+
+	void encode(frame_t &f)
+	{
+		if (multi())
+		{
+			f.bits[encoder::FRAME_BYTES - 1] = _rotation->standard(f.slot);
+		}
+		encoder::encode(f.bits, f.hh, f.mm, f.DD, f.MM, f.YY, f.flags, _dut1);
+	}
+
+	void next_minute(frame_t &f)
+	{
+		uint8_t ss = 0;
+		if (multi() | (_dst_rule != TIMECODE_DST_NONE))
+		{
+			// back to the given time, the next minute can be another standard, timezone or DST state
+			const int8_t tz_hh = multi() ? _rotation->tz_hh(f.slot) : _tz_hh;
+			const int8_t tz_mm = multi() ? _rotation->tz_mm(f.slot) : _tz_mm;
+			uint8_t hh = f.hh, mm = f.mm, DD = f.DD, MM = f.MM, YY = f.YY;
+			date_add<uint8_t>(hh, mm, ss, DD, MM, YY, -tz_hh, -tz_mm, 60);
+			to_frame_time(f, hh, mm, DD, MM, YY, f.flags & TIMECODE_DST);
+			return;
+		}
+		date_add<uint8_t>(f.hh, f.mm, ss, f.DD, f.MM, f.YY, 0, 1, 0);
+	}
+
+	// frame time = given time + timezone (of the rotation entry for this minute)
+	void to_frame_time(frame_t &f, uint8_t hh, uint8_t mm, uint8_t DD, uint8_t MM, uint8_t YY, const bool dst)
+	{
+		uint8_t ss = 0;
+		int8_t tz_hh = _tz_hh;
+		int8_t tz_mm = _tz_mm;
+		f.flags = (_dst_rule != TIMECODE_DST_NONE) ? timecode_dst_flags(_dst_rule, hh, mm, DD, MM, YY) : (dst ? TIMECODE_DST_ALL : 0);
+		f.slot = 0;
+		if (multi())
+		{
+			f.slot = _rotation->slot(hh, mm, DD, MM, YY);
+			tz_hh = _rotation->tz_hh(f.slot);
+			tz_mm = _rotation->tz_mm(f.slot);
+		}
+		// set_leap_second() is the month of the given time, not of the frame time after the offset
+		if ((MM == _leap_MM) & (YY == _leap_YY))
+		{
+			f.flags |= TIMECODE_LEAP_MONTH;
+		}
+		date_add<uint8_t>(hh, mm, ss, DD, MM, YY, tz_hh, tz_mm, 0);
+		f.hh = hh; f.mm = mm; f.DD = DD; f.MM = MM; f.YY = YY;
+	}
+
+	void load(const frame_t &f)
+	{
+		const bool is_active = _is_active;
+		stop();
+		frame_t &active = _frame[_active];
+		active = f;
+		encode(active);
+		_next_ready = false;
+		if (is_active)
+		{
+			start();
+		}
+	}
+
+	static bool same_minute(const frame_t &a, const frame_t &b)
+	{
+		return (a.hh == b.hh) & (a.mm == b.mm) & (a.DD == b.DD) & (a.MM == b.MM) & (a.YY == b.YY) & (a.flags == b.flags) & (a.slot == b.slot);
+	}
+public:
+	epoch_clock clock;
+
+	// carrier error and the receiver pass band (round robin : the carrier before a rotation is set)
+	static const int16_t CARRIER_ERROR_HZ = timecode_carrier_error_hz(TIMER::CLOCK_HZ, TIMER::tick_hz(encoder::CARRIER_HZ), encoder::CARRIER_HZ);
+	static const bool CARRIER_RX = timecode_carrier_rx(TIMER::CLOCK_HZ, TIMER::tick_hz(encoder::CARRIER_HZ), encoder::CARRIER_HZ);
+
+	timecode_tx() : _active(0), _next_ready(false), _is_active(false), _ss(0), _count(1),
+		_slot(0), _slots(0), _last_slot(0), _ticks_frac(0), _phase(0),
+#if (WWVB_DITHER == 1)
+		_top(0), _top_frac(0), _top_phase(0),
+#endif
+		_duty_high(0), _duty_low(0), _percent(TIMER::PWM ? WWVB_PWM_LOW : 0), _trim_q16(0), _rotation(0),
+		_pps_adjust(0), _pps_pending(false), _pps_error(0), _pps_good(0), _tz_hh(0), _tz_mm(0),
+		_dst_rule(TIMECODE_DST_NONE), _dut1(0), _leap_MM(0), _leap_YY(0)
+	{
+#if (WWVB_DRIFT == 1)
+		_dr_started = false;
+		_dr_ref = false;
+		_dr_base = false;
+		_dr_auto = false;
+		memset(&_dr, 0, sizeof(_dr));
+#endif
+#if (WWVB_DUAL == 1)
+		_duty_high_b = 0;
+		_duty_low_b = 0;
+		_phase_b = WWVB_PHASE_0;
+		_percent_b = WWVB_PWM_LOW;
+#endif
+	}
+
+	void setup()
+	{
+		stop();
+#if (WWVB_ISR_STATS == 1)
+		reset_stats();
+#endif
+#if (WWVB_LOOPBACK == 1)
+		_lb_head = 0;
+		_lb_tail = 0;
+		reset_loopback();
+#endif
+		// TOP, prescaler and the second timing are set by set_ticks()
+		TIMER::setup(encoder::CARRIER_HZ);
+#if (WWVB_DUAL == 1)
+		if (DUAL)
+		{
+			pinMode(10, OUTPUT);
+			TCCR1A |= _BV(COM1B1) | ((_phase_b == WWVB_PHASE_180) ? _BV(COM1B0) : 0);
+		}
+#endif
+		TIMER::output(0);
+		TIMER::sync();
+		set_ticks();
+#if (WWVB_DUAL == 1)
+		output_b(off_b());
+#endif
+	}
+
+	// Signed trim in carrier cycles per second
+	// e.g. a 16MHz resonator that is 20ppm fast needs +1 (59925 * 20e-6)
+	void calibrate(const int16_t trim)
+	{
+		calibrate_q16(static_cast<int32_t>(trim) << 16);
+	}
+
+	// Signed trim in 1/65536 carrier cycles per second (0.00025ppm @ 59925 cycles per second)
+	// e.g. 20ppm fast : 59925 * 20e-6 * 65536 = +78545
+	void calibrate_q16(const int32_t correction)
+	{
+		cli();
+		_trim_q16 = correction;
+		sei();
+		set_ticks();
+	}
+
+	// Add to the trim, Q16 carrier cycles per second, keeps the PPS steps made in the meantime
+	void adjust_q16(const int32_t correction)
+	{
+		cli();
+		_trim_q16 += correction;
+		sei();
+		set_ticks();
+	}
+
+	// Set the pulse width used for the reduced power level, as a percentage of the high level
+	// Note : 0 turns the carrier off, WWVB_PWM_LOW_TRUE is the level of the real transmitter
+	// Note : the wwvb_timer2 backend has no pulse width, it is always carrier off
+	void setPWM_LOW(const uint8_t percent)
+	{
+		_percent = TIMER::PWM ? percent : 0;
+		set_ticks();
+	}
+
+#if (WWVB_DUAL == 1)
+	// Second coil on OC1B : WWVB_PHASE_0 (in phase with OC1A) or WWVB_PHASE_180 (H-bridge),
+	// percent is its reduced power level as setPWM_LOW() (e.g. a nearer coil can be weaker)
+	void set_output_b(const uint8_t phase, const uint8_t percent)
+	{
+		_phase_b = phase;
+		_percent_b = percent;
+		cli();
+		if (DUAL)
+		{
+			TCCR1A = (phase == WWVB_PHASE_180) ? (TCCR1A | _BV(COM1B0)) : (TCCR1A & ~_BV(COM1B0));
+		}
+		if (!_is_active)
+		{
+			output_b(off_b());
+		}
+		sei();
+		set_ticks();
+	}
+#endif
+
+	// Round robin : transmit the standards of the rotation in turn, call before set_time()
+	void set_rotation(timecode_rotation &rotation)
+	{
+		_rotation = &rotation;
+		set_ticks();
+	}
+
+	// The timezone is added to the time given to set_time()
+	void setTimezone(const int8_t tz_hh, const int8_t tz_mm)
+	{
+		_tz_hh = tz_hh;
+		_tz_mm = tz_mm;
+	}
+
+	// DST flags from a rule (TIMECODE_DST_US, _EU or _AU) for the given standard time,
+	// TIMECODE_DST_NONE sends the dst argument of set_time() / sync_time()
+	void set_dst_rule(const uint8_t rule)
+	{
+		_dst_rule = rule;
+	}
+
+	// UT1 - UTC in 0.1s (-9 to 9), sent by WWVB and MSF
+	void set_dut1(const int8_t dut1)
+	{
+		_dut1 = (dut1 < -9) ? -9 : (dut1 > 9) ? 9 : dut1;
+	}
+
+	// A leap second is inserted at the end of MM/YY (0 = none), WWVB and JJY warn for that month
+	void set_leap_second(const uint8_t MM, const uint8_t YY)
+	{
+		_leap_MM = MM;
+		_leap_YY = YY;
+	}
+
+	// Set the time for the minute that starts on the next start()
+	void set_time(uint8_t hh, uint8_t mm, uint8_t DD, uint8_t MM, uint8_t YY, const bool dst = false)
+	{
+		clock.set(hh, mm, 0, DD, MM, YY);
+		frame_t f;
+		to_frame_time(f, hh, mm, DD, MM, YY, dst);
+		load(f);
+	}
+
+	// Start the transmission at second 0 of the minute given to set_time()
+	void start()
+	{
+#if (WWVB_DRIFT == 1)
+		drift_start();
+#endif
+		cli();
+		// second 0 starts now, with the first slot of the frame reference marker
+		if (multi())
+		{
+			apply(_rotation->carrier[_frame[_active].slot]);
+		}
+		_ss = 0;
+		_slot = 0;
+		_slots = encoder::slots(_frame[_active].bits, 0);
+		_count = _ticks_slot;
+		_pps_adjust = 0;
+		_pps_pending = false;
+#if (WWVB_ISR_STATS == 1)
+		_stats_ref = false;
+#endif
+		TIMER::output((_slots & 0x01) ? _duty_low : _duty_high);
+#if (WWVB_DUAL == 1)
+		output_b((_slots & 0x01) ? _duty_low_b : _duty_high_b);
+#endif
+#if (WWVB_LOOPBACK == 1)
+		_lb_started = false;
+		_lb_low_on = false;
+		trace(0, _slots);
+#endif
+		_is_active = true;
+		clock.ticked(true);
+		TIMER::start();
+		sei();
+		TIMER::sync();
+	}
+
+	void stop()
+	{
+		TIMER::stop();
+		TIMER::output(0);
+#if (WWVB_DUAL == 1)
+		output_b(off_b());
+#endif
+		_is_active = false;
+		clock.ticked(false);
+		TIMER::sync();
+	}
+
+	bool is_active() { return _is_active; }
+
+	// Last PPS phase error in carrier cycles (+ve : the transmitter second started before the PPS edge)
+	int16_t pps_error() { return _pps_error; }
+	int16_t trim() { return (trim_q16() + 0x8000L) >> 16; } // rounded to whole cycles
+
+	int32_t trim_q16()
+	{
+		cli();
+		const int32_t t = _trim_q16;
+		sei();
+		return t;
+	}
+
+	// PPS edges within 8 cycles of the transmitter second since the last call
+	// e.g. >= 50 in a minute : the trim is disciplined, see wwvb_calibration.h
+	uint8_t pps_good_seconds()
+	{
+		cli();
+		const uint8_t n = _pps_good;
+		_pps_good = 0;
+		sei();
+		return n;
+	}
+
+	// Call from the GPS PPS pin interrupt (rising edge = start of the GPS second)
+	void pps_interrupt()
+	{
+		if (!_is_active | _pps_pending)
+		{
+			return;
+		}
+
+		// carrier cycles since the transmitter second started
+		const uint8_t slot = _slot;
+		uint32_t elapsed = slot * _ticks_slot + ((slot == TIMECODE_SLOTS - 1) ? _last_slot : _ticks_slot) - _count;
+		if (TIMER::pending())
+		{
+			++elapsed; // interrupt pending behind this one
+		}
+		// the second in progress : in the last slot it already has the last correction,
+		// before it the last slot is loaded with the nominal _ticks_last (and the fractional carry)
+		const uint32_t second = (slot == TIMECODE_SLOTS - 1) ? (TIMECODE_SLOTS - 1) * static_cast<uint32_t>(_ticks_slot) + _last_slot
+			: _ticks_per_second;
+
+		// the transmitter is (re)started after the NMEA sentence, so it is normally late.
+		// Only treat it as early when the edge lands in the first 1/8th of its second
+		int32_t error;
+		if (elapsed < (second >> 3))
+		{
+			error = elapsed;
+		}
+		else
+		{
+			error = static_cast<int32_t>(elapsed - second);
+		}
+		_pps_error = (error < -0x7FFF) ? -0x7FFF : error;
+
+		if ((error > -8) & (error < 8) & (_pps_good < 0xFF))
+		{
+			++_pps_good;
+		}
+
+		if (error == 0)
+		{
+			return;
+		}
+
+		// a small error that repeats every second is a rate error, integrate 1/4 of it into the trim
+		if ((error > -8) & (error < 8))
+		{
+			const int32_t step = error * (65536L / 4);
+			_trim_q16 += step;
+			step_ticks(step);
+		}
+
+		// phase : stretch or shrink the last slot of the second, at most 50ms per second
+		const int32_t max_adjust = _ticks_slot >> 1;
+		if (error > max_adjust)
+		{
+			error = max_adjust;
+		}
+		else if (error < -max_adjust)
+		{
+			error = -max_adjust;
+		}
+		_pps_adjust = error;
+		_pps_pending = true;
+	}
+
+	// Encode the next minute into the back buffer, call this from loop()
+	// Returns true if a frame was encoded
+	bool update()
+	{
+#if (WWVB_LOOPBACK == 1)
+		loopback_decode();
+#endif
+		if (!_is_active | _next_ready)
+		{
+			return false;
+		}
+		frame_t &next = _frame[_active ^ 1];
+		next = _frame[_active];
+		if (multi())
+		{
+			// pick up PPS trim steps, the ISR reloads the carrier from the rotation
+			set_carriers(trim_q16());
+		}
+		next_minute(next);
+		encode(next);
+		_next_ready = true;
+		return true;
+	}
+
+	// Check the transmitted time against a reference at second 0 of the minute hh:mm
+	// (e.g. when the GPS sentence for ss = 0 arrives), without stopping the transmission
+	// * agrees within a second : nothing to do, returns false
+	// * wrong minute/date : the time is corrected at the next minute boundary
+	// * out by more than a second : the transmission restarts now at hh:mm
+	bool sync_time(uint8_t hh, uint8_t mm, uint8_t DD, uint8_t MM, uint8_t YY, const bool dst = false)
+	{
+		if (!_is_active)
+		{
+			set_time(hh, mm, DD, MM, YY, dst);
+			start();
+			return true;
+		}
+
+		frame_t ref;
+		to_frame_time(ref, hh, mm, DD, MM, YY, dst);
+
+		cli();
+		const uint8_t tx_ss = _ss;
+		const uint8_t active = _active;
+		sei();
+
+		const uint32_t t = date_to_seconds(hh, mm, 0, DD, MM, YY);
+		if ((tx_ss > 1) & (tx_ss < 59))
+		{
+			clock.set(t);
+			load(ref);
+			return true;
+		}
+
+		// within a second of the reference, keep the clock in step with the transmitted second
+		clock.set((tx_ss == 59) ? t - 1 : t + tx_ss);
+#if (WWVB_DRIFT == 1)
+		cli();
+		_dr_label = ((tx_ss == 59) ? t - 1 : t + tx_ss) - _dr_seconds;
+		sei();
+#endif
+
+		// the minute the transmitter should start on its next minute boundary
+		if (tx_ss != 59)
+		{
+			next_minute(ref);
+		}
+		// the next minute is worked out aside, the back buffer (if ready) stays ready for a minute
+		// boundary that comes first and is only replaced under cli()
+		frame_t next = _frame[active];
+		next_minute(next);
+
+		const bool drifted = !same_minute(next, ref);
+		if (drifted)
+		{
+			next = ref;
+		}
+		encode(next);
+		cli();
+		const bool swapped = (_active != active);
+		if (!swapped)
+		{
+			_frame[active ^ 1] = next;
+			_next_ready = true;
+		}
+		sei();
+		if (swapped & drifted)
+		{
+			// the old back buffer went out on this minute boundary, restart on the right minute
+			load(next);
+		}
+		return drifted;
+	}
+
+	// Time of the frame being transmitted
+	uint8_t hh() { return _frame[_active].hh; }
+	uint8_t mm() { return _frame[_active].mm; }
+	uint8_t ss() { return _ss; }
+	uint8_t DD() { return _frame[_active].DD; }
+	uint8_t MM() { return _frame[_active].MM; }
+	uint8_t YY() { return _frame[_active].YY; }
+
+#if (WWVB_ISR_STATS == 1)
+	void reset_stats()
+	{
+		cli();
+		memset(&_stats, 0, sizeof(_stats));
+		_stats.latency_min = 0xFFFF;
+		_stats.duration_min = 0xFFFF;
+		_stats_n = 0;
+		_stats_ref = false;
+		sei();
+	}
+
+	void get_stats(wwvb_isr_stats &stats)
+	{
+		cli();
+		stats = _stats;
+		sei();
+	}
+
+	void print_stats(Print &out)
+	{
+		wwvb_isr_stats stats;
+		get_stats(stats);
+		out.print(F("ISR count    : ")); out.println(stats.count);
+		out.print(F("ISR latency  : ")); out.print(stats.latency_min); out.print(F(" - ")); out.print(stats.latency_max);
+		out.println(F(" cycles"));
+		out.print(F("ISR duration : ")); out.print(stats.duration_min); out.print(F(" - ")); out.print(stats.duration_max);
+		out.println(F(" cycles"));
+		out.print(F("ISR overrun  : ")); out.println(stats.overrun);
+		out.print(F("ISR lost     : ")); out.print(stats.lost); out.println(F(" cycles"));
+		for (uint8_t i = 0; i < WWVB_STATS_BINS; ++i)
+		{
+			out.print(F("  latency >= ")); out.print(i << WWVB_STATS_SHIFT); out.print(F(" : "));
+			out.println(stats.latency[i]);
+		}
+	}
+#endif
+
+#if (WWVB_LOOPBACK == 1)
+	void reset_loopback()
+	{
+		memset(&_lb, 0, sizeof(_lb));
+		_lb_minute_bad = 0;
+	}
+
+	void get_loopback(wwvb_loopback_stats &stats)
+	{
+		stats = _lb;
+	}
+
+	// The seconds up to WWVB_LOOPBACK_SECONDS ago as traced by the ISR, 0 = the last one
+	void get_trace(const uint8_t age, wwvb_loopback_second &second)
+	{
+		const uint8_t head = _lb_head;
+		const uint8_t i = (age < head) ? head - 1 - age : head + WWVB_LOOPBACK_SECONDS - 1 - age;
+		cli();
+		second = _lb_ring[i % WWVB_LOOPBACK_SECONDS];
+		sei();
+	}
+
+	void print_loopback(Print &out)
+	{
+		out.print(F("TX seconds   : ")); out.print(_lb.seconds); out.print(F(", bad ")); out.println(_lb.bad_seconds);
+		out.print(F("TX minutes   : ")); out.print(_lb.bad_minutes); out.print(F(" bad, last ")); out.print(_lb.last_minute);
+		out.print(F(" worst ")); out.print(_lb.worst_minute); out.println(F(" bad seconds"));
+		out.print(F("TX worst     : ")); out.print(_lb.worst_ms); out.println(F(" ms"));
+	}
+#endif
+
+#if (WWVB_DRIFT == 1)
+	// Rate errors over WWVB_DRIFT_DEADBAND_PPB are taken out of the trim (no PPS)
+	void set_drift_auto(const bool on) { _dr_auto = on; }
+
+	// The reference second t (clock time, e.g. date_to_seconds() of the GPS time) started at
+	// micros() t_us, call before the time is set from it (set_time() / sync_time())
+	// Returns the offset of the transmitter second in us (+ve : late), 0 if there is nothing to compare
+	int32_t drift(const uint32_t t, const uint32_t t_us)
+	{
+		_dr_ref = true;
+		_dr_ref_t = t;
+		_dr_ref_us = t_us;
+		if (!_dr_started)
+		{
+			return 0;
+		}
+		cli();
+		const uint32_t us0 = _dr_us;
+		const uint32_t label0 = _dr_label + _dr_seconds;
+		const int32_t trim = _trim_q16;
+		const uint32_t ticks_per_second = _ticks_per_second;
+		sei();
+		const int32_t n = t - label0; // transmitted seconds from the last one that started
+		if ((n < -1) | (n > WWVB_DRIFT_SPAN_MAX))
+		{
+			_dr_base = false;
+			return 0;
+		}
+
+		// a transmitted second is (cycles + trim) / cycles of a CPU second
+		const float trim_us = (trim / 65536.0f) * (1e6f / ticks_per_second);
+		const uint32_t predicted = us0 + n * 1000000L + static_cast<int32_t>(n * trim_us);
+		const int32_t offset = predicted - t_us;
+		_dr.offset_us = offset;
+		if ((offset > 1000000L) | (offset < -1000000L))
+		{
+			_dr_base = false; // on another second, e.g. a holdover start
+			return offset;
+		}
+
+		const uint32_t span = t - _dr_base_t;
+		if (!_dr_base | (span > WWVB_DRIFT_SPAN_MAX))
+		{
+			_dr_base = true;
+			_dr_base_t = t;
+			_dr_base_offset = offset;
+			return offset;
+		}
+		if (span < WWVB_DRIFT_SPAN)
+		{
+			return offset;
+		}
+
+		const int32_t rate = (offset - _dr_base_offset) * (1000.0f / span);
+		const int32_t rate_abs = (rate < 0) ? -rate : rate;
+		_dr_base_t = t;
+		_dr_base_offset = offset;
+		++_dr.count;
+		_dr.rate_ppb = rate;
+		_dr.span = span;
+		if (rate_abs > _dr.worst_ppb)
+		{
+			_dr.worst_ppb = rate_abs;
+		}
+		if (_dr_auto & (rate_abs > WWVB_DRIFT_DEADBAND_PPB) & (rate_abs < WWVB_DRIFT_MAX_PPB))
+		{
+			// long seconds need fewer cycles, half the error per correction rides out the NMEA jitter
+			adjust_q16(-static_cast<int32_t>(rate * (ticks_per_second * 65536e-9f) * 0.5f));
+			++_dr.corrections;
+		}
+		return offset;
+	}
+
+	// The last rate was within WWVB_DRIFT_DEADBAND_PPB, e.g. the disciplined flag of wwvb_calibration
+	bool drift_settled()
+	{
+		const int32_t rate_abs = (_dr.rate_ppb < 0) ? -_dr.rate_ppb : _dr.rate_ppb;
+		return (_dr.count > 1) & (rate_abs <= WWVB_DRIFT_DEADBAND_PPB);
+	}
+
+	void get_drift(wwvb_drift_stats &stats)
+	{
+		stats = _dr;
+	}
+
+	void reset_drift()
+	{
+		memset(&_dr, 0, sizeof(_dr));
+	}
+
+	void print_drift(Print &out)
+	{
+		out.print(F("Drift offset : ")); out.print(_dr.offset_us); out.println(F(" us"));
+		out.print(F("Drift rate   : ")); out.print(_dr.rate_ppb); out.print(F(" ppb over ")); out.print(_dr.span); out.println(F(" s"));
+		out.print(F("Drift worst  : ")); out.print(_dr.worst_ppb); out.print(F(" ppb, ")); out.print(_dr.count);
+		out.print(F(" rates, ")); out.print(_dr.corrections); out.println(F(" corrections"));
+	}
+#endif
+
+	// Call from ISR(TIMER1_OVF_vect), ISR(TIMER2_COMPA_vect) with wwvb_timer2, the wwvb_ledc::attach() tick on the ESP32
+	inline void interrupt_routine()
+	{
+#if (WWVB_ISR_STATS == 1)
+		const uint16_t t_entry = TIMER::count();
+		tick();
+		record(t_entry, TIMER::count());
+#else
+		tick();
+#endif
+	}
+};
+
+typedef timecode_tx<TIMECODE_WWVB> wwvb_frame;
+
+#endif
@@ -0,0 +1,262 @@
+#ifndef WWVB_LEDC_H
+#define WWVB_LEDC_H
+
+/*
+wwvb_ledc : ESP32 carrier timer backend, the TIMER of timecode_tx<STANDARD, wwvb_ledc>
+
+The LEDC peripheral makes the carrier in hardware, nothing runs per carrier cycle.
+The ISR of the AVR backends counts carrier cycles, here it counts 1ms ticks of an
+esp_timer instead : the slots are 100 ticks, the second 1000 and the trim
+(calibrate(), pps_error(), the drift loop) is in ticks of the esp_timer (1 tick =
+1000ppm, calibrate_q16() for the finer steps). The reduced power level is the LEDC
+duty, the same percent of the high level (WWVB_PWM_LOW) as Timer1.
+
+The carrier is the LEDC clock (80MHz APB) over a fractional divider :
+WWVB_LEDC_BITS 8 makes 60.015kHz (+250ppm), DCF77 77.519kHz (+250ppm), JJY40 40kHz. It is
+set once by setup() for the one standard, so there is no round robin on the LEDC.
+
+Included by wwvb_frame.h on the ESP32, usage :
+	timecode_tx<TIMECODE_WWVB> wwvb_tx; // wwvb_ledc is the default TIMER on the ESP32
+	void wwvb_tick()
+	{
+		wwvb_tx.interrupt_routine();
+	}
+	...
+	wwvb_ledc::attach(wwvb_tick); // before wwvb_tx.setup()
+
+The tick is called in the esp_timer task with the wwvb_port_mux() lock held (see
+wwvb_port.h), so the cli() / sei() of wwvb_frame.h and epoch_clock.h keep it out from
+loop() on either core. The lock is a critical section (the interrupts are off on that core
+and the other core spins in cli()), so only the frame state update is made with it : its
+millis() / micros() are esp_timer_get_time() reads. The driver calls are made outside it,
+output() only keeps the duty, the tick writes it to the LEDC after it gives the lock back,
+and start() / stop() only set a flag, sync() (called by the transmitter after sei())
+starts and stops the esp_timer. Jitter is the esp_timer task, ~10-50us on a second edge.
+
+Pin : WWVB_LEDC_PIN (GPIO 25), any output capable GPIO
+*/
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "wwvb_port.h"
+
+#if !defined(ESP32)
+#error wwvb_ledc.h : ESP32 only
+#endif
+
+#ifndef WWVB_LEDC_PIN
+#define WWVB_LEDC_PIN 25
+#endif
+
+#ifndef WWVB_LEDC_CHANNEL
+#define WWVB_LEDC_CHANNEL 0 // core 2.x, the 3.x core picks a free channel
+#endif
+
+#ifndef WWVB_LEDC_BITS
+#define WWVB_LEDC_BITS 8 // duty resolution, the carrier divider error gets worse with more bits
+#endif
+
+#define WWVB_LEDC_TICK_US 1000
+
+struct wwvb_ledc
+{
+	static const uint8_t NUMBER = 0; // not an AVR timer
+	static const uint8_t STEPS = 1;
+	static const uint16_t PERIOD_MAX = 65535;
+	static const bool PWM = true;
+	static const bool ROTATION = false;
+	static const uint32_t CLOCK_HZ = 1000000UL; // the esp_timer counts in us
+
+	static constexpr uint32_t tick_hz(const uint32_t)
+	{
+		return 1000000UL / WWVB_LEDC_TICK_US;
+	}
+
+	typedef void (*handler_t)();
+
+	static handler_t &handler()
+	{
+		static handler_t fn = 0;
+		return fn;
+	}
+
+	static esp_timer_handle_t &timer()
+	{
+		static esp_timer_handle_t t = 0;
+		return t;
+	}
+
+	// The carrier the LEDC divider made, 0 before setup()
+	static double &carrier_hz()
+	{
+		static double hz = 0;
+		return hz;
+	}
+
+	// The LEDC duty output() asked for, written outside the lock
+	static volatile uint32_t &duty()
+	{
+		static volatile uint32_t d = 0;
+		return d;
+	}
+
+	// The duty in the LEDC, the tick only writes a change
+	static volatile uint32_t &written()
+	{
+		static volatile uint32_t d = 0;
+		return d;
+	}
+
+	// Transmitting, set by start() / stop() with the lock held
+	static volatile bool &run()
+	{
+		static volatile bool r = false;
+		return r;
+	}
+
+	// start() calls, a restart re-phases the tick in sync()
+	static volatile uint8_t &starts()
+	{
+		static volatile uint8_t n = 0;
+		return n;
+	}
+
+	// The esp_timer as sync() left it, the ticks are dropped until it matches run() / starts()
+	static volatile bool &running()
+	{
+		static volatile bool r = false;
+		return r;
+	}
+
+	static volatile uint8_t &started()
+	{
+		static volatile uint8_t n = 0;
+		return n;
+	}
+
+	// A tick is writing the LEDC, stop() waits for it so the carrier off isn't overwritten
+	static volatile bool &busy()
+	{
+		static volatile bool b = false;
+		return b;
+	}
+
+	static void write(const uint32_t d)
+	{
+		written() = d;
+#if defined(ESP_ARDUINO_VERSION_MAJOR) & (ESP_ARDUINO_VERSION_MAJOR >= 3)
+		ledcWrite(WWVB_LEDC_PIN, d);
+#else
+		ledcWrite(WWVB_LEDC_CHANNEL, d);
+#endif
+	}
+
+	// The tick, call before the transmitter setup()
+	static void attach(const handler_t fn)
+	{
+		handler() = fn;
+	}
+
+	static void callback(void *)
+	{
+		portENTER_CRITICAL(wwvb_port_mux());
+		const bool on = run() & running() & (starts() == started());
+		if (on & (handler() != 0))
+		{
+			handler()();
+		}
+		const uint32_t d = duty();
+		const bool change = on & (d != written());
+		busy() = change;
+		portEXIT_CRITICAL(wwvb_port_mux());
+		if (change)
+		{
+			write(d);
+			busy() = false;
+		}
+	}
+
+	static void setup(const uint32_t hz)
+	{
+#if defined(ESP_ARDUINO_VERSION_MAJOR) & (ESP_ARDUINO_VERSION_MAJOR >= 3)
+		ledcAttach(WWVB_LEDC_PIN, hz, WWVB_LEDC_BITS);
+		carrier_hz() = ledcReadFreq(WWVB_LEDC_PIN);
+#else
+		carrier_hz() = ledcSetup(WWVB_LEDC_CHANNEL, hz, WWVB_LEDC_BITS);
+		ledcAttachPin(WWVB_LEDC_PIN, WWVB_LEDC_CHANNEL);
+#endif
+		if (!timer())
+		{
+			esp_timer_create_args_t args = {};
+			args.callback = callback;
+			args.name = "wwvb";
+			esp_timer_create(&args, &timer());
+		}
+	}
+
+	// The carrier is fixed by setup(), the tick period by WWVB_LEDC_TICK_US
+	static inline void top(const timecode_carrier &) {}
+
+	// the tick is a whole number of us, nothing to dither
+	static inline bool dither(const uint16_t) { return true; }
+
+	static inline uint16_t period()
+	{
+		return WWVB_LEDC_TICK_US;
+	}
+
+	// duty : of the tick period (the Timer1 pulse width math), scaled to the LEDC resolution
+	// Kept for the tick (or sync()) to write, no driver call with the lock held
+	static inline void output(const uint16_t d)
+	{
+		duty() = (static_cast<uint32_t>(d) << WWVB_LEDC_BITS) / WWVB_LEDC_TICK_US;
+	}
+
+	// with the wwvb_port_mux() lock held, the esp_timer is started by sync()
+	static inline void start()
+	{
+		run() = true;
+		starts() = starts() + 1;
+	}
+
+	// the lock nests, a tick on the other core either sees run() off or is busy() by the time it returns
+	static inline void stop()
+	{
+		portENTER_CRITICAL(wwvb_port_mux());
+		run() = false;
+		portEXIT_CRITICAL(wwvb_port_mux());
+	}
+
+	// With the lock free, after start() / stop() : (re)starts the tick on the second 0 just set, or stops it
+	static void sync()
+	{
+		const bool on = run();
+		if ((on == running()) & (!on | (starts() == started())))
+		{
+			return;
+		}
+		esp_timer_stop(timer());
+		while (busy()) {} // a tick on the other core is writing the LEDC
+		write(duty());
+		started() = starts();
+		running() = on;
+		if (on)
+		{
+			esp_timer_start_periodic(timer(), WWVB_LEDC_TICK_US);
+		}
+	}
+
+	// esp_timer doesn't queue a late tick, it skips it
+	static inline bool pending()
+	{
+		return false;
+	}
+
+	// WWVB_ISR_STATS only, not on the ESP32
+	static inline uint16_t count()
+	{
+		return 0;
+	}
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef WWVB_PORT_H
+#define WWVB_PORT_H
+
+/*
+wwvb_port : cli() / sei() for the headers that share state with the carrier interrupt
+
+AVR : <avr/interrupt.h>, interrupts off on the one core.
+
+ESP32 : the carrier tick (wwvb_ledc.h) runs in the esp_timer task, which can be on the
+other core from loop(), so turning the interrupts off on this core keeps nothing out.
+cli() / sei() take and give one spinlock (wwvb_port_mux()) instead, and the tick holds it
+too. The lock nests on the core that holds it, e.g. a cli() inside the tick.
+*/
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+
+inline portMUX_TYPE *wwvb_port_mux()
+{
+	static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+	return &mux;
+}
+
+#undef cli
+#undef sei
+#define cli() portENTER_CRITICAL(wwvb_port_mux())
+#define sei() portEXIT_CRITICAL(wwvb_port_mux())
+#elif defined(ESP8266)
+// one core, the core's interrupt lock
+#ifndef cli
+#define cli() noInterrupts()
+#define sei() interrupts()
+#endif
+#else
+#include <avr/interrupt.h>
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef WWVB_SCHEDULE_H
+#define WWVB_SCHEDULE_H
+
+/*
+wwvb_schedule : daily transmit windows
+
+Radio controlled clocks only try to receive a few times a night, so outside
+the windows the transmitter is stopped and the GPS can be switched off.
+Windows are in local time and may wrap past midnight (e.g. 23:00 - 01:30).
+
+The standby time is kept with millis(), so the GPS is powered up 'warmup'
+minutes before the next window to get a fix and absorb the resonator error
+(0.5% is ~7 minutes a day)
+*/
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+
+#define WWVB_MINUTES_PER_DAY 1440
+
+struct wwvb_window
+{
+	uint8_t start_hh, start_mm;
+	uint8_t end_hh, end_mm;
+};
+
+class wwvb_schedule
+{
+private:
+	const wwvb_window *_window; // PROGMEM
+	uint8_t _count;
+	uint8_t _warmup;
+	bool _standby;
+	uint32_t _t0;
+	uint32_t _standby_ms;
+
+	static uint16_t minutes(const uint8_t hh, const uint8_t mm)
+	{
+		return static_cast<uint16_t>(hh) * 60 + mm;
+	}
+
+	uint16_t start(const uint8_t i)
+	{
+		return minutes(pgm_read_byte(&_window[i].start_hh), pgm_read_byte(&_window[i].start_mm));
+	}
+
+	uint16_t end(const uint8_t i)
+	{
+		return minutes(pgm_read_byte(&_window[i].end_hh), pgm_read_byte(&_window[i].end_mm));
+	}
+public:
+	wwvb_schedule(const wwvb_window *window, const uint8_t count, const uint8_t warmup = 10) :
+		_window(window), _count(count), _warmup(warmup), _standby(false), _t0(0), _standby_ms(0) {}
+
+	bool in_window(const uint8_t hh, const uint8_t mm)
+	{
+		const uint16_t t = minutes(hh, mm);
+		for (uint8_t i = 0; i < _count; ++i)
+		{
+			const uint16_t t_start = start(i);
+			const uint16_t t_end = end(i);
+			if (t_start <= t_end)
+			{
+				if ((t >= t_start) & (t < t_end))
+				{
+					return true;
+				}
+			}
+			else if ((t >= t_start) | (t < t_end)) // wraps past midnight
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Minutes from hh:mm to the start of the next window
+	uint16_t minutes_to_window(const uint8_t hh, const uint8_t mm)
+	{
+		const uint16_t t = minutes(hh, mm);
+		uint16_t next = WWVB_MINUTES_PER_DAY;
+		for (uint8_t i = 0; i < _count; ++i)
+		{
+			const uint16_t dt = (start(i) + WWVB_MINUTES_PER_DAY - t) % WWVB_MINUTES_PER_DAY;
+			if (dt < next)
+			{
+				next = dt;
+			}
+		}
+		return next;
+	}
+
+	// Outside the windows, but within 'warmup' minutes of the next one : the GPS stays on
+	bool warming(const uint8_t hh, const uint8_t mm)
+	{
+		return !in_window(hh, mm) & (minutes_to_window(hh, mm) <= _warmup);
+	}
+
+	// Stand by until 'warmup' minutes before the next window, from the local time hh:mm:ss
+	void standby(const uint8_t hh, const uint8_t mm, const uint8_t ss)
+	{
+		uint16_t m = minutes_to_window(hh, mm);
+		m = (m > _warmup) ? m - _warmup : 0;
+		_standby_ms = static_cast<uint32_t>(m) * 60000UL;
+		_standby_ms = (_standby_ms > ss * 1000UL) ? _standby_ms - ss * 1000UL : 0;
+		_t0 = millis();
+		_standby = true;
+	}
+
+	bool is_standby() { return _standby; }
+
+	// Returns true once when the standby time is over
+	bool wake()
+	{
+		if (_standby & (millis() - _t0 >= _standby_ms))
+		{
+			_standby = false;
+			return true;
+		}
+		return false;
+	}
+};
+
+#endif
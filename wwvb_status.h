@@ -0,0 +1,184 @@
+#ifndef WWVB_STATUS_H
+#define WWVB_STATUS_H
+
+/*
+wwvb_status : compact binary status frame for fleet monitoring
+
+send() writes one frame to any Print (Serial, or a WiFiUDP packet on the ESP32), put
+together in the foreground from the counters the transmitter already keeps (readers that
+turn the interrupts off for a copy), so it costs the ISR nothing. The frame is written
+byte by byte with the checksum worked out on the way, nothing is buffered : the state is
+the uptime, the sync count and the checksum, 14 bytes. Call it from a task, e.g. every 10s
+in the middle of a second so it stays off the second edge, and synced() from the sync code.
+
+Frame, little endian :
+	0xB5 0x57 | version | length | payload (length bytes) | CK_A CK_B
+The checksum is the UBX one (8 bit Fletcher) over version, length and the payload, so
+a reader can find the frames in a serial stream that also carries the debug text.
+
+Payload, the sections in this order, a section is only sent if its bit is set in sections :
+	base, 18 bytes
+		u8  sections  WWVB_STATUS_DRIFT | WWVB_STATUS_LOOPBACK | WWVB_STATUS_ISR
+		u8  flags     WWVB_STATUS_ACTIVE | WWVB_STATUS_VALID | WWVB_STATUS_HOLDOVER | WWVB_STATUS_SETTLED
+		u8  quality   the GGA fix quality of the time source (NTP : 1 while it is valid)
+		u8  satellites                                       (NTP : the server stratum)
+		u32 uptime    seconds
+		u32 clock     wwvb_tx.clock, the local seconds since 2000 (see date_table.h)
+		u16 syncs     synced() calls
+		i32 trim_q16  the calibration, Q16 carrier cycles per second
+	WWVB_STATUS_DRIFT (WWVB_DRIFT 1), 18 bytes : wwvb_drift_stats
+		i32 offset_us, i32 rate_ppb, i32 worst_ppb, u16 count, u16 corrections, u16 span
+	WWVB_STATUS_LOOPBACK (WWVB_LOOPBACK 1), 14 bytes : wwvb_loopback_stats
+		u32 seconds, u32 bad_seconds, u16 bad_minutes, u8 last_minute, u8 worst_minute, u16 worst_ms
+	WWVB_STATUS_ISR (WWVB_ISR_STATS 1), 50 bytes : wwvb_isr_stats
+		u32 count, u16 latency_min, u16 latency_max, u16 duration_min, u16 duration_max, u16 overrun,
+		u32 latency[WWVB_STATS_BINS] (the entry latency histogram, 32 CPU cycles a bin)
+
+e.g. with WWVB_DRIFT 1 a frame is 42 bytes, within the 64 byte Serial buffer of the AVR
+core, so send() doesn't wait on the UART. The stats aren't reset, the differences between
+two frames are the counts in between.
+*/
+
+#include <Arduino.h>
+
+#define WWVB_STATUS_SYNC1 0xB5
+#define WWVB_STATUS_SYNC2 0x57 // 'W'
+#define WWVB_STATUS_VERSION 1
+
+// sections
+#define WWVB_STATUS_DRIFT 0x01
+#define WWVB_STATUS_LOOPBACK 0x02
+#define WWVB_STATUS_ISR 0x04
+
+// flags
+#define WWVB_STATUS_ACTIVE 0x01 // transmitting
+#define WWVB_STATUS_VALID 0x02 // the time source has a valid time (GPS fix, NTP reply)
+#define WWVB_STATUS_HOLDOVER 0x04 // transmitting the RTC time
+#define WWVB_STATUS_SETTLED 0x08 // the resync drift is within WWVB_DRIFT_DEADBAND_PPB
+
+#define WWVB_STATUS_BASE 18
+#define WWVB_STATUS_DRIFT_SIZE 18
+#define WWVB_STATUS_LOOPBACK_SIZE 14
+#define WWVB_STATUS_ISR_SIZE (14 + 4 * WWVB_STATS_BINS)
+
+template <typename TX>
+class wwvb_status
+{
+private:
+	TX &_tx;
+	uint32_t _uptime; // seconds
+	uint32_t _uptime_ms; // millis() of the last whole second counted
+	uint16_t _syncs;
+	uint8_t _ck_a, _ck_b;
+
+	void put(Print &out, const uint8_t b)
+	{
+		out.write(b);
+		_ck_a += b;
+		_ck_b += _ck_a;
+	}
+
+	void put16(Print &out, const uint16_t v)
+	{
+		put(out, v);
+		put(out, v >> 8);
+	}
+
+	void put32(Print &out, const uint32_t v)
+	{
+		put16(out, v);
+		put16(out, v >> 16);
+	}
+public:
+	wwvb_status(TX &tx) : _tx(tx), _uptime(0), _uptime_ms(0), _syncs(0), _ck_a(0), _ck_b(0) {}
+
+	// Count a sync from the time source (the GPS / NTP time set or checked)
+	void synced() { ++_syncs; }
+
+	uint16_t syncs() { return _syncs; }
+
+	// Seconds since boot, kept past the 49 day millis() rollover (call at least every 49 days)
+	uint32_t uptime()
+	{
+		const uint32_t elapsed = millis() - _uptime_ms;
+		_uptime += elapsed / 1000;
+		_uptime_ms += elapsed - elapsed % 1000;
+		return _uptime;
+	}
+
+	// flags : WWVB_STATUS_VALID / WWVB_STATUS_HOLDOVER from the sketch, the rest are added
+	void send(Print &out, const uint8_t quality, const uint8_t satellites, uint8_t flags = 0)
+	{
+		uint8_t sections = 0;
+		uint8_t length = WWVB_STATUS_BASE;
+		flags |= _tx.is_active() ? WWVB_STATUS_ACTIVE : 0;
+#if (WWVB_DRIFT == 1)
+		sections |= WWVB_STATUS_DRIFT;
+		length += WWVB_STATUS_DRIFT_SIZE;
+		flags |= _tx.drift_settled() ? WWVB_STATUS_SETTLED : 0;
+#endif
+#if (WWVB_LOOPBACK == 1)
+		sections |= WWVB_STATUS_LOOPBACK;
+		length += WWVB_STATUS_LOOPBACK_SIZE;
+#endif
+#if (WWVB_ISR_STATS == 1)
+		sections |= WWVB_STATUS_ISR;
+		length += WWVB_STATUS_ISR_SIZE;
+#endif
+
+		out.write(WWVB_STATUS_SYNC1);
+		out.write(WWVB_STATUS_SYNC2);
+		_ck_a = 0;
+		_ck_b = 0;
+		put(out, WWVB_STATUS_VERSION);
+		put(out, length);
+
+		put(out, sections);
+		put(out, flags);
+		put(out, quality);
+		put(out, satellites);
+		put32(out, uptime());
+		put32(out, _tx.clock.now());
+		put16(out, _syncs);
+		put32(out, _tx.trim_q16());
+#if (WWVB_DRIFT == 1)
+		wwvb_drift_stats dr;
+		_tx.get_drift(dr);
+		put32(out, dr.offset_us);
+		put32(out, dr.rate_ppb);
+		put32(out, dr.worst_ppb);
+		put16(out, dr.count);
+		put16(out, dr.corrections);
+		put16(out, dr.span);
+#endif
+#if (WWVB_LOOPBACK == 1)
+		wwvb_loopback_stats lb;
+		_tx.get_loopback(lb);
+		put32(out, lb.seconds);
+		put32(out, lb.bad_seconds);
+		put16(out, lb.bad_minutes);
+		put(out, lb.last_minute);
+		put(out, lb.worst_minute);
+		put16(out, lb.worst_ms);
+#endif
+#if (WWVB_ISR_STATS == 1)
+		wwvb_isr_stats isr;
+		_tx.get_stats(isr);
+		put32(out, isr.count);
+		put16(out, isr.latency_min);
+		put16(out, isr.latency_max);
+		put16(out, isr.duration_min);
+		put16(out, isr.duration_max);
+		put16(out, isr.overrun);
+		for (uint8_t i = 0; i < WWVB_STATS_BINS; ++i)
+		{
+			put32(out, isr.latency[i]);
+		}
+#endif
+
+		out.write(_ck_a);
+		out.write(_ck_b);
+	}
+};
+
+#endif
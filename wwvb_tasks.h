@@ -0,0 +1,148 @@
+#ifndef WWVB_TASKS_H
+#define WWVB_TASKS_H
+
+/*
+wwvb_tasks : fixed slot cooperative scheduler for loop()
+
+The tasks are a PROGMEM table, run in 100ms slots of the epoch_clock, i.e. on
+the transmitted second boundaries while wwvb_tx ticks the clock (and millis()
+while it freewheels), so a once a second task always runs just after the ISR
+has started the second, never half way through it.
+
+Each run() is one slice :
+* the period 0 tasks (e.g. the GPS parser, the frame encoder) run on every slice
+* then at most one due periodic task, the first in the table, the rest wait for the next slice
+so a slow task (the SPI display push) costs the GPS parser one slice, not its UART buffer.
+
+A task is a plain function that returns within its budget (budget_ms), e.g. by parsing a
+bounded number of bytes. The runs that take longer, and the longest run, are counted to
+find the task that starves the rest.
+
+Usage :
+	const wwvb_task tasks_table[] PROGMEM = {
+		{ taskGPS, 0, 0, 2 },      // every slice
+		{ taskDisplay, 10, 0, 20 } // once a second, in slot 0
+		};
+	wwvb_tasks tasks(tasks_table, sizeof(tasks_table) / sizeof(tasks_table[0]), wwvb_tx.clock);
+	loop() : tasks.run(); idle();
+
+Note : a clock that is set (e.g. to the GPS time) realigns the tasks, a due task runs once
+*/
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "epoch_clock.h"
+
+#define WWVB_TASKS_MAX 8
+#define WWVB_TASK_SLOTS 10 // 100ms slots per second
+
+typedef void (*wwvb_task_fn)();
+
+struct wwvb_task
+{
+	wwvb_task_fn run;
+	uint8_t period; // 100ms slots, 0 = every slice
+	uint8_t phase; // slot in the period
+	uint8_t budget_ms;
+};
+
+class wwvb_tasks
+{
+private:
+	const wwvb_task *_task; // PROGMEM
+	uint8_t _count;
+	epoch_clock &_clock;
+
+	uint32_t _next[WWVB_TASKS_MAX]; // due slot
+	uint16_t _longest[WWVB_TASKS_MAX]; // us
+	uint16_t _overruns[WWVB_TASKS_MAX];
+
+	// Slot of the day, the seconds since 2000 x 10 don't fit in 32 bits
+	uint32_t slot()
+	{
+		uint16_t ms;
+		const uint32_t t = _clock.now(ms) % DATE_SECONDS_PER_DAY;
+		return t * WWVB_TASK_SLOTS + ms / (1000 / WWVB_TASK_SLOTS);
+	}
+
+	void execute(const uint8_t i)
+	{
+		const wwvb_task_fn fn = reinterpret_cast<wwvb_task_fn>(pgm_read_ptr(&_task[i].run));
+		const uint32_t t0 = micros();
+		fn();
+		const uint32_t dt = micros() - t0;
+		if (dt > _longest[i])
+		{
+			_longest[i] = (dt < 0xFFFF) ? dt : 0xFFFF;
+		}
+		if ((dt > pgm_read_byte(&_task[i].budget_ms) * 1000UL) & (_overruns[i] < 0xFFFF))
+		{
+			++_overruns[i];
+		}
+	}
+public:
+	wwvb_tasks(const wwvb_task *task, const uint8_t count, epoch_clock &clock) :
+		_task(task), _count((count < WWVB_TASKS_MAX) ? count : WWVB_TASKS_MAX), _clock(clock)
+	{
+		for (uint8_t i = 0; i < WWVB_TASKS_MAX; ++i)
+		{
+			_next[i] = 0;
+		}
+		reset_stats();
+	}
+
+	// One slice, call from loop()
+	void run()
+	{
+		_clock.update();
+		const uint32_t now = slot();
+		bool periodic = false;
+		for (uint8_t i = 0; i < _count; ++i)
+		{
+			const uint8_t period = pgm_read_byte(&_task[i].period);
+			if (period == 0)
+			{
+				execute(i);
+				continue;
+			}
+			// due, or more than a period away (the clock was set back, or midnight)
+			const bool due = (static_cast<int32_t>(now - _next[i]) >= 0) | (_next[i] - now > period);
+			if (periodic | !due)
+			{
+				continue;
+			}
+			periodic = true;
+			const uint8_t phase = pgm_read_byte(&_task[i].phase);
+			_next[i] = now - (now + period - phase % period) % period + period;
+			execute(i);
+		}
+	}
+
+	uint16_t longest_us(const uint8_t i) { return _longest[i]; }
+	uint16_t overruns(const uint8_t i) { return _overruns[i]; }
+
+	void reset_stats()
+	{
+		for (uint8_t i = 0; i < WWVB_TASKS_MAX; ++i)
+		{
+			_longest[i] = 0;
+			_overruns[i] = 0;
+		}
+	}
+
+	// "task N: longest US us, overruns N" for each task
+	void print_stats(Print &out)
+	{
+		for (uint8_t i = 0; i < _count; ++i)
+		{
+			out.print(F("task "));
+			out.print(i);
+			out.print(F(": longest "));
+			out.print(_longest[i]);
+			out.print(F(" us, overruns "));
+			out.println(_overruns[i]);
+		}
+	}
+};
+
+#endif